@@ -13,15 +13,17 @@ INCLUDE_DIR="bumi"
 BIN_DIR="bin"
 MAIN_BINARY="bumi"
 TEST_WINDOW_BINARY="bumi_window_test"
+BENCH_BINARIES="bumi_fillrect_bench bumi_instanced_bench bumi_multiwindow_bench"
 
 # Compiler and flags
 CXX="g++"
 CXXFLAGS="-g -O2 -I$INCLUDE_DIR"
-LDFLAGS="-lX11 -lGL"
+LDFLAGS="-lX11 -lXext -lGL -ldl -pthread"
 
 # Source files
-MAIN_SOURCES="$SRC_DIR/ventor/bumi_sysvideo.c $SRC_DIR/main.cpp"
-TEST_WINDOW_SOURCES="$SRC_DIR/ventor/bumi_sysvideo.c $TEST_DIR/bumi_window_test.cpp"
+LIB_SOURCES="$SRC_DIR/ventor/bumi_sysvideo.c $SRC_DIR/ventor/bumi_swrender.c"
+MAIN_SOURCES="$LIB_SOURCES $SRC_DIR/main.cpp"
+TEST_WINDOW_SOURCES="$LIB_SOURCES $TEST_DIR/bumi_window_test.cpp"
 
 # Function to print colored messages
 print_message() {
@@ -103,6 +105,33 @@ build_test_window() {
     fi
 }
 
+# Build the benchmark programs
+build_bench() {
+    print_message "$YELLOW" "Creating bin directory..."
+    mkdir -p "$BIN_DIR"
+
+    for bench in $BENCH_BINARIES; do
+        print_message "$YELLOW" "Compiling $bench program..."
+        if $CXX $CXXFLAGS $LIB_SOURCES "$TEST_DIR/$bench.cpp" -o "$BIN_DIR/$bench" $LDFLAGS; then
+            print_message "$GREEN" "$bench build successful: $bench"
+        else
+            print_message "$RED" "$bench build failed."
+            exit 1
+        fi
+    done
+}
+
+# Run the benchmark programs
+run_bench() {
+    for bench in $BENCH_BINARIES; do
+        print_message "$YELLOW" "Running $bench..."
+        if ! $XVFB timeout 60s "$BIN_DIR/$bench"; then
+            print_message "$RED" "$bench failed: Check output for errors."
+            exit 1
+        fi
+    done
+}
+
 # Run main tests
 run_main_tests() {
     print_message "$YELLOW" "Running main tests..."
@@ -148,6 +177,11 @@ case "$1" in
         build_test_window
         run_test_window
         ;;
+    bench)
+        check_dependencies
+        build_bench
+        run_bench
+        ;;
     *)
         check_dependencies
         build_main
@@ -0,0 +1,389 @@
+#include "bumi_swrender.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define BUMI_SW_X86 1
+    #include <immintrin.h>
+#else
+    #define BUMI_SW_X86 0
+#endif
+
+#define BUMI_SW_TILE_W 256
+#define BUMI_SW_TILE_H 64
+#define BUMI_SW_MAX_THREADS 16
+
+typedef void (*BUMI_SWSpanFill)(uint32_t* dst, int n, uint32_t color);
+
+struct BUMI_SWPool {
+    pthread_t threads[BUMI_SW_MAX_THREADS];
+    int thread_count;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint64_t generation; // Bumped once per job
+    int busy;            // Workers still running the current job
+    bool quit;
+
+    // Current job
+    const BUMI_SWSurface* target;
+    const BUMI_SWCommand* commands;
+    int command_count;
+    const BUMI_SWVertex* vertices;
+    int tiles_x;
+    int tile_count;
+    int next_tile;       // Claimed with an atomic increment
+};
+
+static BUMI_SWSpanFill span_fill = NULL;
+
+#if !BUMI_SW_X86
+static void span_fill_scalar(uint32_t* dst, int n, uint32_t color) {
+    for (int i = 0; i < n; i++) {
+        dst[i] = color;
+    }
+}
+#else
+static void span_fill_sse2(uint32_t* dst, int n, uint32_t color) {
+    __m128i value = _mm_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm_storeu_si128((__m128i*)(dst + i), value);
+        _mm_storeu_si128((__m128i*)(dst + i + 4), value);
+        _mm_storeu_si128((__m128i*)(dst + i + 8), value);
+        _mm_storeu_si128((__m128i*)(dst + i + 12), value);
+    }
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128((__m128i*)(dst + i), value);
+    }
+    for (; i < n; i++) {
+        dst[i] = color;
+    }
+}
+
+__attribute__((target("avx2")))
+static void span_fill_avx2(uint32_t* dst, int n, uint32_t color) {
+    __m256i value = _mm256_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        _mm256_storeu_si256((__m256i*)(dst + i), value);
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), value);
+        _mm256_storeu_si256((__m256i*)(dst + i + 16), value);
+        _mm256_storeu_si256((__m256i*)(dst + i + 24), value);
+    }
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_si256((__m256i*)(dst + i), value);
+    }
+    for (; i < n; i++) {
+        dst[i] = color;
+    }
+}
+#endif
+
+static void select_span_fill(void) {
+    if (span_fill) return;
+
+#if BUMI_SW_X86
+    __builtin_cpu_init();
+    span_fill = __builtin_cpu_supports("avx2") ? span_fill_avx2 : span_fill_sse2;
+#else
+    span_fill = span_fill_scalar;
+#endif
+}
+
+static int clip_rect(const BUMI_Rect* a, const BUMI_Rect* b, BUMI_Rect* out) {
+    int x0 = a->x > b->x ? a->x : b->x;
+    int y0 = a->y > b->y ? a->y : b->y;
+    int x1 = a->x + a->w < b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y1 = a->y + a->h < b->y + b->h ? a->y + a->h : b->y + b->h;
+    if (x1 <= x0 || y1 <= y0) {
+        return 0;
+    }
+    out->x = x0;
+    out->y = y0;
+    out->w = x1 - x0;
+    out->h = y1 - y0;
+    return 1;
+}
+
+static uint32_t blend_pixel(uint32_t src, uint32_t dst) {
+    uint32_t a = src >> 24;
+    if (a == 255) return src;
+    if (a == 0) return dst;
+
+    uint32_t inv = 255 - a;
+    uint32_t rb = ((src & 0x00FF00FFu) * a + (dst & 0x00FF00FFu) * inv) >> 8;
+    uint32_t g = ((src & 0x0000FF00u) * a + (dst & 0x0000FF00u) * inv) >> 8;
+    return 0xFF000000u | (rb & 0x00FF00FFu) | (g & 0x0000FF00u);
+}
+
+static uint32_t swap_rb(uint32_t pixel) {
+    return (pixel & 0xFF00FF00u) | ((pixel >> 16) & 0xFFu) | ((pixel & 0xFFu) << 16);
+}
+
+// Per-channel multiply, rounding so that 255 * x stays x
+static uint32_t modulate_pixel(uint32_t pixel, uint32_t color) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t c = ((pixel >> shift) & 0xFFu) * ((color >> shift) & 0xFFu);
+        out |= ((c + 255) >> 8) << shift;
+    }
+    return out;
+}
+
+// Nearest-neighbour scaled blit with alpha blending, limited to `clip`
+static void copy_rect(const BUMI_SWSurface* target, const BUMI_SWCommand* cmd, const BUMI_Rect* clip) {
+    const BUMI_SWSurface* tex = cmd->texture;
+    for (int y = clip->y; y < clip->y + clip->h; y++) {
+        int sy = cmd->src.y + (int)((int64_t)(y - cmd->dst.y) * cmd->src.h / cmd->dst.h);
+        const uint32_t* src_row = tex->pixels + (size_t) sy * tex->pitch;
+        uint32_t* dst_row = target->pixels + (size_t) y * target->pitch;
+        for (int x = clip->x; x < clip->x + clip->w; x++) {
+            int sx = cmd->src.x + (int)((int64_t)(x - cmd->dst.x) * cmd->src.w / cmd->dst.w);
+            uint32_t pixel = src_row[sx];
+            if (cmd->swap_rb) {
+                pixel = swap_rb(pixel);
+            }
+            if (cmd->color != 0xFFFFFFFFu) {
+                pixel = modulate_pixel(pixel, cmd->color);
+            }
+            dst_row[x] = blend_pixel(pixel, dst_row[x]);
+        }
+    }
+}
+
+static float edge(const BUMI_SWVertex* a, const BUMI_SWVertex* b, float x, float y) {
+    return (b->x - a->x) * (y - a->y) - (b->y - a->y) * (x - a->x);
+}
+
+// Pixels on an edge belong to the triangle only if it is a top or left
+// edge, so triangles sharing that edge never both draw them
+static bool edge_owns(const BUMI_SWVertex* a, const BUMI_SWVertex* b) {
+    float dx = b->x - a->x;
+    float dy = b->y - a->y;
+    return dy > 0 || (dy == 0 && dx < 0);
+}
+
+static uint32_t lerp_color(const uint32_t c[3], float w0, float w1, float w2) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        float v = ((c[0] >> shift) & 0xFFu) * w0 + ((c[1] >> shift) & 0xFFu) * w1 + ((c[2] >> shift) & 0xFFu) * w2;
+        uint32_t byte = v <= 0.0f ? 0 : v >= 255.0f ? 255 : (uint32_t)(v + 0.5f);
+        out |= byte << shift;
+    }
+    return out;
+}
+
+// Edge-function rasterizer sampling at pixel centers, limited to `clip`.
+// Colors (and texture coordinates) interpolate barycentrically; untextured
+// triangles overwrite like fills, textured ones blend like copies
+static void draw_triangle(const BUMI_SWSurface* target, const BUMI_SWCommand* cmd, const BUMI_SWVertex* vertices,
+                          const BUMI_Rect* clip) {
+    const BUMI_SWVertex* v0 = &vertices[cmd->first_vertex];
+    const BUMI_SWVertex* v1 = v0 + 1;
+    const BUMI_SWVertex* v2 = v0 + 2;
+    float area = edge(v0, v1, v2->x, v2->y);
+    if (area < 0) {
+        const BUMI_SWVertex* t = v1;
+        v1 = v2;
+        v2 = t;
+        area = -area;
+    }
+    bool own0 = edge_owns(v1, v2), own1 = edge_owns(v2, v0), own2 = edge_owns(v0, v1);
+    const uint32_t colors[3] = {v0->color, v1->color, v2->color};
+    bool flat = colors[0] == colors[1] && colors[1] == colors[2];
+    const BUMI_SWSurface* tex = cmd->texture;
+    float inv_area = 1.0f / area;
+
+    for (int y = clip->y; y < clip->y + clip->h; y++) {
+        float py = y + 0.5f;
+        uint32_t* dst_row = target->pixels + (size_t) y * target->pitch;
+        for (int x = clip->x; x < clip->x + clip->w; x++) {
+            float px = x + 0.5f;
+            float e0 = edge(v1, v2, px, py);
+            float e1 = edge(v2, v0, px, py);
+            float e2 = edge(v0, v1, px, py);
+            if (e0 < 0 || e1 < 0 || e2 < 0 || (e0 == 0 && !own0) || (e1 == 0 && !own1) || (e2 == 0 && !own2)) {
+                continue;
+            }
+            float w0 = e0 * inv_area, w1 = e1 * inv_area, w2 = e2 * inv_area;
+            uint32_t color = flat ? colors[0] : lerp_color(colors, w0, w1, w2);
+            if (!tex) {
+                dst_row[x] = color;
+                continue;
+            }
+
+            int sx = (int)((v0->u * w0 + v1->u * w1 + v2->u * w2) * tex->w);
+            int sy = (int)((v0->v * w0 + v1->v * w1 + v2->v * w2) * tex->h);
+            sx = sx < 0 ? 0 : sx >= tex->w ? tex->w - 1 : sx;
+            sy = sy < 0 ? 0 : sy >= tex->h ? tex->h - 1 : sy;
+            uint32_t pixel = tex->pixels[(size_t) sy * tex->pitch + sx];
+            if (cmd->swap_rb) {
+                pixel = swap_rb(pixel);
+            }
+            if (color != 0xFFFFFFFFu) {
+                pixel = modulate_pixel(pixel, color);
+            }
+            dst_row[x] = blend_pixel(pixel, dst_row[x]);
+        }
+    }
+}
+
+static void run_tile(const BUMI_SWSurface* target, const BUMI_SWCommand* commands, int count,
+                     const BUMI_SWVertex* vertices, const BUMI_Rect* tile) {
+    for (int i = 0; i < count; i++) {
+        const BUMI_SWCommand* cmd = &commands[i];
+        BUMI_Rect area;
+
+        if (cmd->type == BUMI_SW_CMD_CLEAR) {
+            area = *tile;
+        } else if (!clip_rect(&cmd->dst, tile, &area)) {
+            continue;
+        }
+
+        if (cmd->type == BUMI_SW_CMD_COPY) {
+            copy_rect(target, cmd, &area);
+            continue;
+        }
+        if (cmd->type == BUMI_SW_CMD_TRIANGLE) {
+            draw_triangle(target, cmd, vertices, &area);
+            continue;
+        }
+        for (int y = area.y; y < area.y + area.h; y++) {
+            span_fill(target->pixels + (size_t) y * target->pitch + area.x, area.w, cmd->color);
+        }
+    }
+}
+
+static void run_tiles(BUMI_SWPool* pool) {
+    for (;;) {
+        int index = __atomic_fetch_add(&pool->next_tile, 1, __ATOMIC_RELAXED);
+        if (index >= pool->tile_count) {
+            return;
+        }
+
+        BUMI_Rect tile;
+        tile.x = (index % pool->tiles_x) * BUMI_SW_TILE_W;
+        tile.y = (index / pool->tiles_x) * BUMI_SW_TILE_H;
+        tile.w = pool->target->w - tile.x < BUMI_SW_TILE_W ? pool->target->w - tile.x : BUMI_SW_TILE_W;
+        tile.h = pool->target->h - tile.y < BUMI_SW_TILE_H ? pool->target->h - tile.y : BUMI_SW_TILE_H;
+        run_tile(pool->target, pool->commands, pool->command_count, pool->vertices, &tile);
+    }
+}
+
+static void* worker_main(void* arg) {
+    BUMI_SWPool* pool = (BUMI_SWPool*) arg;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->quit && pool->generation == seen) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->quit) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_tiles(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+BUMI_SWPool* bumi_sw_pool_create(int threads) {
+    select_span_fill();
+
+    BUMI_SWPool* pool = (BUMI_SWPool*) BUMI_internal_calloc(1, sizeof(BUMI_SWPool));
+    if (!pool) {
+        return NULL;
+    }
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int) cpus : 1;
+    }
+    // The calling thread takes tiles too, so it counts as one of the workers
+    threads -= 1;
+    if (threads > BUMI_SW_MAX_THREADS) {
+        threads = BUMI_SW_MAX_THREADS;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            break;
+        }
+        pool->thread_count++;
+    }
+    return pool;
+}
+
+void bumi_sw_pool_destroy(BUMI_SWPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    BUMI_internal_free(pool);
+}
+
+void bumi_sw_execute(BUMI_SWPool* pool, const BUMI_SWSurface* target, const BUMI_SWCommand* commands, int count,
+                     const BUMI_SWVertex* vertices) {
+    if (!pool || !target || target->w <= 0 || target->h <= 0 || count <= 0) {
+        return;
+    }
+
+    // Everything before the last clear is overwritten by it
+    int first = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        if (commands[i].type == BUMI_SW_CMD_CLEAR) {
+            first = i;
+            break;
+        }
+    }
+
+    pool->target = target;
+    pool->commands = commands + first;
+    pool->command_count = count - first;
+    pool->vertices = vertices;
+    pool->tiles_x = (target->w + BUMI_SW_TILE_W - 1) / BUMI_SW_TILE_W;
+    pool->tile_count = pool->tiles_x * ((target->h + BUMI_SW_TILE_H - 1) / BUMI_SW_TILE_H);
+    pool->next_tile = 0;
+
+    if (pool->thread_count > 0 && pool->tile_count > 1) {
+        pthread_mutex_lock(&pool->lock);
+        pool->busy = pool->thread_count;
+        pool->generation++;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+
+        run_tiles(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        while (pool->busy > 0) {
+            pthread_cond_wait(&pool->done, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    } else {
+        run_tiles(pool);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef BUMI_SWRENDER_H
+#define BUMI_SWRENDER_H
+
+// === INTERNAL CPU RASTERIZER FOR THE SOFTWARE RENDERER ===
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bumi_sysvideo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 32-bit pixels, 0xAARRGGBB in native order (BGRA bytes on little endian)
+typedef struct {
+    uint32_t* pixels;
+    int w, h;
+    int pitch; // In pixels
+} BUMI_SWSurface;
+
+enum {
+    BUMI_SW_CMD_CLEAR = 1,
+    BUMI_SW_CMD_FILL,
+    BUMI_SW_CMD_COPY,
+    BUMI_SW_CMD_TRIANGLE
+};
+
+// Triangle corner: pixel position, normalized texture coordinates and a
+// color packed like the target's pixels
+typedef struct {
+    float x, y;
+    float u, v;
+    uint32_t color;
+} BUMI_SWVertex;
+
+typedef struct {
+    int type;
+    uint32_t color;                // Clear and fill color; copies multiply by it
+    BUMI_Rect dst;                 // Triangles: their bounding box
+    BUMI_Rect src;                 // Copy only
+    const BUMI_SWSurface* texture; // Copy, and textured triangles
+    bool swap_rb;                  // Texture holds RGBA bytes instead of BGRA
+    int first_vertex;              // Triangle only, three entries of the vertex array
+} BUMI_SWCommand;
+
+// The library's allocator, as set with BUMI_SetMemoryFunctions
+void* BUMI_internal_malloc(size_t size);
+void* BUMI_internal_calloc(size_t count, size_t size);
+void* BUMI_internal_realloc(void* ptr, size_t size);
+void BUMI_internal_free(void* ptr);
+
+typedef struct BUMI_SWPool BUMI_SWPool;
+
+// Create a pool of `threads` workers (<= 0 picks one per online CPU)
+BUMI_SWPool* bumi_sw_pool_create(int threads);
+void bumi_sw_pool_destroy(BUMI_SWPool* pool);
+
+// Rasterize commands into the target. The target is split into tiles that
+// the pool's workers and the calling thread fill in parallel. Triangle
+// commands index into `vertices`
+void bumi_sw_execute(BUMI_SWPool* pool, const BUMI_SWSurface* target, const BUMI_SWCommand* commands, int count,
+                     const BUMI_SWVertex* vertices);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
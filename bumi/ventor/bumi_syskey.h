@@ -7,9 +7,17 @@
 #define BUMI_QUIT 0x100
 #define BUMI_KEYDOWN 0x300
 #define BUMI_KEYUP 0x301
+#define BUMI_MOUSEMOTION 0x400
+#define BUMI_MOUSEBUTTONDOWN 0x401
+#define BUMI_MOUSEBUTTONUP 0x402
+#define BUMI_MOUSEWHEEL 0x403
 #define BUMI_WINDOWEVENT 0x200
+#define BUMI_WINDOWEVENT_EXPOSED 3 // The window was repainted after being uncovered
 #define BUMI_WINDOWEVENT_CLOSE 4
-#define BUMI_WINDOWEVENT_RESIZED 5
+#define BUMI_WINDOWEVENT_RESIZED 5 // data1, data2: new width and height
+#define BUMI_USEREVENT 0x8000 // First type BUMI_RegisterEvents hands out
+#define BUMI_FIRSTEVENT 0
+#define BUMI_LASTEVENT 0xFFFF
 
 typedef uint32_t BUMI_WindowID;
 
@@ -91,24 +99,96 @@ typedef enum {
     BUMI_KEY_RALT
 } BUMI_Keycode;
 
+// Dense index of a key: character keys keep their code, the keys from
+// BUMI_KEY_F1 on follow at 128
+#define BUMI_KEY_INDEX(key) ((int)(key) < 0x1000 ? (int)(key) : 128 + (int)(key) - 0x1000)
+#define BUMI_NUM_KEY_INDICES 256
+// Test a key in the bitset returned by BUMI_GetKeyboardState
+#define BUMI_KEY_HELD(state, key) (((state)[BUMI_KEY_INDEX(key) >> 5] >> (BUMI_KEY_INDEX(key) & 31)) & 1u)
+
+// Mouse buttons, and their bits in BUMI_MouseMotionEvent::state
+#define BUMI_BUTTON_LEFT 1
+#define BUMI_BUTTON_MIDDLE 2
+#define BUMI_BUTTON_RIGHT 3
+#define BUMI_BUTTON_X1 4
+#define BUMI_BUTTON_X2 5
+#define BUMI_BUTTON_MASK(button) (1u << ((button) - 1))
+
+// timestamp is when the event happened, on the BUMI_GetTicksNS clock:
+// input events carry X server time (millisecond resolution) mapped onto
+// it, others the time they were read. capture_ns is always the time the
+// library read the event off the connection
+typedef struct {
+    uint32_t type;
+    uint64_t timestamp;
+    BUMI_WindowID windowID;
+    uint64_t capture_ns;
+} BUMI_CommonEvent;
+
 typedef struct {
     uint32_t type; // BUMI_KEYDOWN, BUMI_KEYUP
-    uint32_t timestamp;
+    uint64_t timestamp;
     BUMI_WindowID windowID;
+    uint64_t capture_ns;
     BUMI_Keycode keycode;
 } BUMI_KeyEvent;
 
 typedef struct {
     uint32_t type; // BUMI_WINDOWEVENT
-    uint32_t timestamp;
+    uint64_t timestamp;
     BUMI_WindowID windowID;
-    uint8_t window_event; // BUMI_WINDOWEVENT_CLOSE, BUMI_WINDOWEVENT_RESIZED
+    uint64_t capture_ns;
+    uint8_t window_event; // BUMI_WINDOWEVENT_*
+    int32_t data1;
+    int32_t data2;
 } BUMI_WindowEvent;
 
+typedef struct {
+    uint32_t type; // BUMI_MOUSEMOTION
+    uint64_t timestamp;
+    BUMI_WindowID windowID;
+    uint64_t capture_ns;
+    uint32_t state;     // Held buttons, BUMI_BUTTON_MASK bits
+    int32_t x, y;       // Pointer position in the window
+    float xrel, yrel;   // Motion since the previous event; raw device units with XInput2
+} BUMI_MouseMotionEvent;
+
+typedef struct {
+    uint32_t type; // BUMI_MOUSEBUTTONDOWN, BUMI_MOUSEBUTTONUP
+    uint64_t timestamp;
+    BUMI_WindowID windowID;
+    uint64_t capture_ns;
+    uint8_t button;     // BUMI_BUTTON_*
+    int32_t x, y;
+} BUMI_MouseButtonEvent;
+
+typedef struct {
+    uint32_t type; // BUMI_MOUSEWHEEL
+    uint64_t timestamp;
+    BUMI_WindowID windowID;
+    uint64_t capture_ns;
+    int32_t x, y;       // Notches scrolled: right and away from the user are positive
+} BUMI_MouseWheelEvent;
+
+typedef struct {
+    uint32_t type; // Returned by BUMI_RegisterEvents
+    uint64_t timestamp;
+    BUMI_WindowID windowID;
+    uint64_t capture_ns;
+    int32_t code;
+    void* data1;
+    void* data2;
+} BUMI_UserEvent;
+
 typedef union {
     uint32_t type;
+    BUMI_CommonEvent common;
     BUMI_KeyEvent key;
     BUMI_WindowEvent window;
+    BUMI_MouseMotionEvent motion;
+    BUMI_MouseButtonEvent button;
+    BUMI_MouseWheelEvent wheel;
+    BUMI_UserEvent user;
 } BUMI_Event;
 
 #endif
\ No newline at end of file
@@ -1,25 +1,212 @@
 #include "bumi_sysvideo.h"
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <inttypes.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <time.h>
+#include <math.h>
 #include <unistd.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/Xatom.h>
+#include <X11/Xresource.h>
+#include <X11/extensions/XShm.h>
 #include <GL/gl.h>
 #include <GL/glx.h>
+#include "bumi_swrender.h"
+
+// Raw mouse motion needs the XInput2 client headers; libXi itself is
+// loaded at runtime
+#if defined(__has_include)
+    #if __has_include(<X11/extensions/XInput2.h>)
+        #include <X11/extensions/XInput2.h>
+        #define BUMI_HAVE_XI2 1
+    #endif
+#endif
+#ifndef BUMI_HAVE_XI2
+    #define BUMI_HAVE_XI2 0
+#endif
+
+// Atoms interned in one XInternAtoms round trip at init
+enum {
+    BUMI_ATOM_WM_PROTOCOLS,
+    BUMI_ATOM_WM_DELETE_WINDOW,
+    BUMI_ATOM_NET_WM_NAME,
+    BUMI_ATOM_UTF8_STRING,
+    BUMI_ATOM_COUNT
+};
+
+static const char* atom_names[BUMI_ATOM_COUNT] = {
+    "WM_PROTOCOLS",
+    "WM_DELETE_WINDOW",
+    "_NET_WM_NAME",
+    "UTF8_STRING"
+};
+
+// Translated events waiting for the app; a power of two
+#define BUMI_EVENT_RING_SIZE 256
+// Event-to-dequeue latency histogram: 16 one-microsecond buckets, then
+// 8 per doubling
+#define BUMI_LATENCY_BUCKETS 256
+// Input thread -> app handoff; a power of two
+#define BUMI_INPUT_RING_SIZE 1024
+// Events pushed from any thread, waiting for the next pump; a power of two
+#define BUMI_USER_QUEUE_SIZE 1024
+
+// Keyboard and pointer events, selected on the input connection
+#define BUMI_INPUT_EVENT_MASK (KeyPressMask | KeyReleaseMask | FocusChangeMask | PointerMotionMask | \
+                               ButtonPressMask | ButtonReleaseMask | EnterWindowMask | LeaveWindowMask)
+
+// Fixed-size objects carved out of slabs; freed ones are kept for reuse
+#define BUMI_POOL_SLAB_OBJECTS 16
+
+typedef struct BUMI_PoolSlab {
+    struct BUMI_PoolSlab* next;
+} BUMI_PoolSlab;
+
+typedef struct {
+    size_t object_size;
+    void* free_list;           // Each free object starts with the next one
+    BUMI_PoolSlab* slabs;
+} BUMI_ObjectPool;
+
+// Bump allocator for data that lives only until the next present. A frame
+// that does not fit gets extra blocks; at the end of the frame the arena
+// grows to cover them, so the next frame of that size allocates nothing
+typedef struct BUMI_ArenaBlock {
+    struct BUMI_ArenaBlock* next;
+} BUMI_ArenaBlock;
+
+typedef struct {
+    uint8_t* base;
+    size_t capacity;
+    size_t used;
+    size_t overflow;           // Bytes handed out from extra blocks
+    BUMI_ArenaBlock* extra;
+} BUMI_FrameArena;
 
 typedef struct {
     Display* dpy;
     int screen;
     Window root;
     int ref_count;
-    Atom wm_delete;
+    Atom atoms[BUMI_ATOM_COUNT];
     BUMI_Window* windows;
+    // Xlib's hashed association tables: X window -> BUMI_Window and
+    // BUMI_WindowID -> BUMI_Window, so lookups do not walk `windows`
+    XContext window_context;
+    XContext id_context;
+    BUMI_WindowID next_window_id; // IDs start at 1 and are never reused
+
+    // Resolved once at init; every window uses this visual so any renderer
+    // can attach to it without a per-window GLX lookup
+    GLXFBConfig fbconfig;      // NULL when the display has no GLX
+    Visual* visual;
+    int depth;
+    Colormap colormap;         // Owned only when visual is not the default
+
+    // Startup timing, CLOCK_MONOTONIC
+    int64_t init_start_ns;
+    int64_t init_end_ns;
+    int64_t first_window_ns;
+    int64_t first_present_ns;
+
+    BUMI_ObjectPool window_pool;
+    BUMI_ObjectPool renderer_pool;
+    BUMI_FrameArena frame_arena;
+
+    // Scratch list for BUMI_RenderPresentAll, grown as needed
+    BUMI_Renderer** present_list;
+    int present_capacity;
+
+    BUMI_Event event_ring[BUMI_EVENT_RING_SIZE];
+    int event_head;            // Oldest queued event
+    int event_count;
+
+    // X server time -> CLOCK_MONOTONIC, kept by whichever thread translates input
+    int64_t server_time_offset;
+    bool server_time_synced;
+
+    uint32_t latency_buckets[BUMI_LATENCY_BUCKETS];
+    uint64_t latency_count;
+    uint64_t latency_max_ns;
+
+    // X keycode -> BUMI_Keycode, built on the first pump and on MappingNotify
+    BUMI_Keycode keymap[256];
+    bool keymap_loaded;
+    uint32_t key_state[BUMI_NUM_KEY_INDICES / 32]; // Held keys, by BUMI_KEY_INDEX
+
+    // Pointer, tracked from crossing, motion and button events
+    BUMI_WindowID mouse_window; // Window under the pointer, 0 if none
+    int mouse_x, mouse_y;
+    uint32_t mouse_state;       // BUMI_BUTTON_MASK bits
+    bool mouse_full_resolution; // Queue every motion sample instead of coalescing
+    bool input_ready;           // XInput2 probed
+    void* xi_lib;               // libXi, kept open until the display is closed
+    int xi_opcode;
+    bool xi_raw;                // Raw motion selected; motion events come from it
+
+    // eventfd bumped when events are queued off the main thread; the
+    // flag saves the write while a wakeup is already pending
+    int wake_fd;
+    bool wake_pending;
+
+    // Connection input is read from: dpy, or the input thread's own one
+    Display* input_dpy;
+    bool input_threaded;
+    pthread_t input_thread;
+    int input_stop_fd;          // eventfd that tells the input thread to exit
+    BUMI_Event input_ring[BUMI_INPUT_RING_SIZE];
+    // Free-running indices, a cache line apart; the app advances head,
+    // the input thread advances tail
+    uint32_t input_head;
+    char input_pad[60];
+    uint32_t input_tail;
+    char input_tail_pad[60];
+
+    // Bounded multi-producer queue behind BUMI_PushEvent. A cell's sequence
+    // says whose turn it is: its index when free for the producer claiming
+    // that position, index + 1 once filled for the consumer
+    struct {
+        uint32_t sequence;
+        BUMI_Event event;
+    } user_queue[BUMI_USER_QUEUE_SIZE];
+    uint32_t user_head;         // Advanced by the pump alone
+    char user_pad[60];
+    uint32_t user_tail;         // Claimed by producers with compare-and-swap
 } BUMI_X11Context;
 
+static int input_thread_start(void);
+static void input_thread_stop(void);
+
 static BUMI_X11Context* ctx = NULL;
-static char bumi_error[256] = "";
+// Thread-local so command buffers can be recorded from worker threads
+static __thread char bumi_error[256] = "";
+
+static int64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+uint64_t BUMI_GetTicksNS(void) {
+    return (uint64_t) monotonic_ns();
+}
+
+uint64_t BUMI_GetPerformanceCounter(void) {
+    return (uint64_t) monotonic_ns();
+}
+
+uint64_t BUMI_GetPerformanceFrequency(void) {
+    return 1000000000ULL;
+}
 
 static void set_error(const char* fmt, ...) {
     va_list args;
@@ -36,24 +223,264 @@ void BUMI_ClearError(void) {
     bumi_error[0] = '\0';
 }
 
+// === MEMORY ===
+
+static BUMI_malloc_func bumi_malloc_func = malloc;
+static BUMI_calloc_func bumi_calloc_func = calloc;
+static BUMI_realloc_func bumi_realloc_func = realloc;
+static BUMI_free_func bumi_free_func = free;
+static uint64_t bumi_allocation_count = 0;
+
+void* BUMI_internal_malloc(size_t size) {
+    __atomic_fetch_add(&bumi_allocation_count, 1, __ATOMIC_RELAXED);
+    return bumi_malloc_func(size);
+}
+
+void* BUMI_internal_calloc(size_t count, size_t size) {
+    __atomic_fetch_add(&bumi_allocation_count, 1, __ATOMIC_RELAXED);
+    return bumi_calloc_func(count, size);
+}
+
+void* BUMI_internal_realloc(void* ptr, size_t size) {
+    __atomic_fetch_add(&bumi_allocation_count, 1, __ATOMIC_RELAXED);
+    return bumi_realloc_func(ptr, size);
+}
+
+// An app's free need not accept NULL
+void BUMI_internal_free(void* ptr) {
+    if (ptr) {
+        bumi_free_func(ptr);
+    }
+}
+
+static char* bumi_strdup(const char* text) {
+    size_t size = strlen(text) + 1;
+    char* copy = (char*) BUMI_internal_malloc(size);
+    if (copy) {
+        memcpy(copy, text, size);
+    }
+    return copy;
+}
+
+int BUMI_SetMemoryFunctions(BUMI_malloc_func malloc_func, BUMI_calloc_func calloc_func,
+                            BUMI_realloc_func realloc_func, BUMI_free_func free_func) {
+    BUMI_ClearError();
+
+    if (!malloc_func || !calloc_func || !realloc_func || !free_func) {
+        set_error("All four memory functions are required");
+        return -1;
+    }
+    if (ctx) {
+        set_error("Memory functions cannot change while the library is initialized");
+        return -1;
+    }
+    bumi_malloc_func = malloc_func;
+    bumi_calloc_func = calloc_func;
+    bumi_realloc_func = realloc_func;
+    bumi_free_func = free_func;
+    return 0;
+}
+
+void BUMI_GetMemoryFunctions(BUMI_malloc_func* malloc_func, BUMI_calloc_func* calloc_func,
+                             BUMI_realloc_func* realloc_func, BUMI_free_func* free_func) {
+    if (malloc_func) *malloc_func = bumi_malloc_func;
+    if (calloc_func) *calloc_func = bumi_calloc_func;
+    if (realloc_func) *realloc_func = bumi_realloc_func;
+    if (free_func) *free_func = bumi_free_func;
+}
+
+uint64_t BUMI_GetAllocationCount(void) {
+    return __atomic_load_n(&bumi_allocation_count, __ATOMIC_RELAXED);
+}
+
+// Slab objects are 16-byte aligned, like malloc's
+static void* pool_alloc(BUMI_ObjectPool* pool) {
+    if (!pool->free_list) {
+        size_t stride = (pool->object_size + 15) & ~(size_t) 15;
+        BUMI_PoolSlab* slab = (BUMI_PoolSlab*) BUMI_internal_malloc(16 + stride * BUMI_POOL_SLAB_OBJECTS);
+        if (!slab) {
+            return NULL;
+        }
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        uint8_t* objects = (uint8_t*) slab + 16;
+        for (int i = BUMI_POOL_SLAB_OBJECTS - 1; i >= 0; i--) {
+            void** object = (void**)(objects + (size_t) i * stride);
+            *object = pool->free_list;
+            pool->free_list = object;
+        }
+    }
+    void** object = (void**) pool->free_list;
+    pool->free_list = *object;
+    return object;
+}
+
+static void pool_free(BUMI_ObjectPool* pool, void* object) {
+    *(void**) object = pool->free_list;
+    pool->free_list = object;
+}
+
+static void pool_destroy(BUMI_ObjectPool* pool) {
+    while (pool->slabs) {
+        BUMI_PoolSlab* next = pool->slabs->next;
+        BUMI_internal_free(pool->slabs);
+        pool->slabs = next;
+    }
+    pool->free_list = NULL;
+}
+
+static void* frame_alloc(size_t size) {
+    BUMI_FrameArena* arena = &ctx->frame_arena;
+    size = (size + 15) & ~(size_t) 15;
+    if (arena->used + size <= arena->capacity) {
+        void* data = arena->base + arena->used;
+        arena->used += size;
+        return data;
+    }
+
+    BUMI_ArenaBlock* block = (BUMI_ArenaBlock*) BUMI_internal_malloc(16 + size);
+    if (!block) {
+        set_error("Failed to allocate frame memory");
+        return NULL;
+    }
+    block->next = arena->extra;
+    arena->extra = block;
+    arena->overflow += size;
+    return (uint8_t*) block + 16;
+}
+
+static size_t frame_mark(void) {
+    return ctx->frame_arena.used;
+}
+
+// Give back everything allocated since `mark`. Once the arena is empty,
+// any extra blocks are folded into one arena big enough for them
+static void frame_release(size_t mark) {
+    BUMI_FrameArena* arena = &ctx->frame_arena;
+    arena->used = mark;
+    if (mark > 0 || !arena->extra) {
+        return;
+    }
+
+    size_t needed = arena->capacity + arena->overflow;
+    while (arena->extra) {
+        BUMI_ArenaBlock* next = arena->extra->next;
+        BUMI_internal_free(arena->extra);
+        arena->extra = next;
+    }
+    arena->overflow = 0;
+    size_t capacity = arena->capacity ? arena->capacity : 4096;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    BUMI_internal_free(arena->base);
+    arena->base = (uint8_t*) BUMI_internal_malloc(capacity);
+    arena->capacity = arena->base ? capacity : 0;
+}
+
+static void frame_destroy(void) {
+    frame_release(0);
+    BUMI_internal_free(ctx->frame_arena.base);
+    memset(&ctx->frame_arena, 0, sizeof(ctx->frame_arena));
+}
+
 static BUMI_Window* find_window(Window x11_window) {
-    BUMI_Window* window = ctx ? ctx->windows : NULL;
-    while (window) {
-        if ((Window)(uintptr_t)window->backend_data == x11_window) {
-            return window;
+    XPointer window = NULL;
+    if (!ctx || XFindContext(ctx->dpy, x11_window, ctx->window_context, &window) != 0) {
+        return NULL;
+    }
+    return (BUMI_Window*) window;
+}
+
+BUMI_Window* BUMI_GetWindowFromID(BUMI_WindowID id) {
+    BUMI_ClearError();
+
+    XPointer window = NULL;
+    if (!ctx || id == 0 || XFindContext(ctx->dpy, id, ctx->id_context, &window) != 0) {
+        set_error("No window with ID %u", (unsigned) id);
+        return NULL;
+    }
+    return (BUMI_Window*) window;
+}
+
+// Double-buffered RGBA config with a TrueColor XRGB8888 visual when there
+// is one, so the GL and software renderers can share every window
+static void choose_fbconfig(void) {
+    ctx->fbconfig = NULL;
+    ctx->visual = DefaultVisual(ctx->dpy, ctx->screen);
+    ctx->depth = DefaultDepth(ctx->dpy, ctx->screen);
+    ctx->colormap = None;
+
+    int error_base, event_base;
+    if (!glXQueryExtension(ctx->dpy, &error_base, &event_base)) {
+        return;
+    }
+
+    static const int attribs[] = {
+        GLX_X_RENDERABLE, True,
+        GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
+        GLX_RENDER_TYPE, GLX_RGBA_BIT,
+        GLX_X_VISUAL_TYPE, GLX_TRUE_COLOR,
+        GLX_RED_SIZE, 8,
+        GLX_GREEN_SIZE, 8,
+        GLX_BLUE_SIZE, 8,
+        GLX_DOUBLEBUFFER, True,
+        None
+    };
+    int count = 0;
+    GLXFBConfig* configs = glXChooseFBConfig(ctx->dpy, ctx->screen, attribs, &count);
+    if (!configs) {
+        return;
+    }
+
+    XVisualInfo* chosen = NULL;
+    for (int i = 0; i < count; i++) {
+        XVisualInfo* vi = glXGetVisualFromFBConfig(ctx->dpy, configs[i]);
+        if (!vi) {
+            continue;
+        }
+        bool xrgb = vi->depth == 24 && vi->red_mask == 0xFF0000 && vi->green_mask == 0xFF00 && vi->blue_mask == 0xFF;
+        if (!chosen || (xrgb && chosen->depth != 24)) {
+            if (chosen) XFree(chosen);
+            chosen = vi;
+            ctx->fbconfig = configs[i];
+        } else {
+            XFree(vi);
+        }
+        if (xrgb) {
+            break;
         }
-        window = window->next;
     }
-    return NULL;
+    XFree(configs);
+    if (!chosen) {
+        return;
+    }
+
+    ctx->visual = chosen->visual;
+    ctx->depth = chosen->depth;
+    if (ctx->visual != DefaultVisual(ctx->dpy, ctx->screen)) {
+        ctx->colormap = XCreateColormap(ctx->dpy, ctx->root, ctx->visual, AllocNone);
+    }
+    XFree(chosen);
 }
 
-static int bumi_init_ctx() {
+static int bumi_init_ctx(uint32_t flags) {
     if (ctx) {
+        if ((flags & BUMI_INIT_INPUT_THREAD) && !ctx->input_threaded) {
+            set_error("The input thread must be requested by the first BUMI_Init");
+            return 0;
+        }
         ctx->ref_count++;
         return 1;
     }
+    // Both connections are used from two threads from here on
+    if ((flags & BUMI_INIT_INPUT_THREAD) && !XInitThreads()) {
+        set_error("Xlib has no thread support");
+        return 0;
+    }
 
-    ctx = (BUMI_X11Context*) malloc(sizeof(BUMI_X11Context));
+    int64_t start = monotonic_ns();
+    ctx = (BUMI_X11Context*) BUMI_internal_calloc(1, sizeof(BUMI_X11Context));
     if (!ctx) {
         set_error("Failed to allocate X11 context");
         return 0;
@@ -61,27 +488,73 @@ static int bumi_init_ctx() {
 
     ctx->dpy = XOpenDisplay(NULL);
     if (!ctx->dpy) {
-        free(ctx);
+        BUMI_internal_free(ctx);
         ctx = NULL;
         set_error("Failed to open X11 display");
         return 0;
     }
 
+    ctx->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctx->wake_fd < 0) {
+        XCloseDisplay(ctx->dpy);
+        BUMI_internal_free(ctx);
+        ctx = NULL;
+        set_error("Failed to create the wakeup eventfd: %s", strerror(errno));
+        return 0;
+    }
+    for (uint32_t i = 0; i < BUMI_USER_QUEUE_SIZE; i++) {
+        ctx->user_queue[i].sequence = i;
+    }
+    ctx->window_pool.object_size = sizeof(BUMI_Window);
+    ctx->renderer_pool.object_size = sizeof(BUMI_Renderer);
+
     ctx->screen = DefaultScreen(ctx->dpy);
     ctx->root = RootWindow(ctx->dpy, ctx->screen);
     ctx->ref_count = 1;
-    ctx->wm_delete = XInternAtom(ctx->dpy, "WM_DELETE_WINDOW", False);
+    XInternAtoms(ctx->dpy, (char**) atom_names, BUMI_ATOM_COUNT, False, ctx->atoms);
     ctx->windows = NULL;
+    ctx->window_context = XUniqueContext();
+    ctx->id_context = XUniqueContext();
+    ctx->next_window_id = 1;
+    ctx->input_dpy = ctx->dpy;
+    choose_fbconfig();
+
+    if ((flags & BUMI_INIT_INPUT_THREAD) && input_thread_start() != 0) {
+        close(ctx->wake_fd);
+        if (ctx->colormap != None) {
+            XFreeColormap(ctx->dpy, ctx->colormap);
+        }
+        XCloseDisplay(ctx->dpy);
+        BUMI_internal_free(ctx);
+        ctx = NULL;
+        return 0;
+    }
+
+    ctx->init_start_ns = start;
+    ctx->init_end_ns = monotonic_ns();
     return 1;
 }
 
 static void bumi_deinit_ctx() {
     if (!ctx || --ctx->ref_count > 0) return;
 
+    input_thread_stop();
+    close(ctx->wake_fd);
+    BUMI_internal_free(ctx->present_list);
+    frame_destroy();
+    pool_destroy(&ctx->window_pool);
+    pool_destroy(&ctx->renderer_pool);
+    if (ctx->colormap != None) {
+        XFreeColormap(ctx->dpy, ctx->colormap);
+    }
     if (ctx->dpy) {
         XCloseDisplay(ctx->dpy);
     }
-    free(ctx);
+    // libXi hooks the display's close, so it goes only after the display
+    if (ctx->xi_lib) {
+        dlclose(ctx->xi_lib);
+    }
+    BUMI_internal_free(ctx);
     ctx = NULL;
 }
 
@@ -89,7 +562,7 @@ int BUMI_Init(uint32_t flags) {
     BUMI_ClearError();
 
     if (flags & BUMI_INIT_VIDEO) {
-        if (!bumi_init_ctx()) {
+        if (!bumi_init_ctx(flags)) {
             return -1;
         }
     } else {
@@ -105,23 +578,37 @@ void BUMI_Quit(void) {
     bumi_deinit_ctx();
 }
 
+int BUMI_GetStartupTiming(BUMI_StartupTiming* timing) {
+    BUMI_ClearError();
+
+    if (!ctx || !timing) {
+        set_error("Bumi is not initialized");
+        return -1;
+    }
+
+    timing->init_ns = ctx->init_end_ns - ctx->init_start_ns;
+    timing->first_window_ns = ctx->first_window_ns ? ctx->first_window_ns - ctx->init_start_ns : 0;
+    timing->first_present_ns = ctx->first_present_ns ? ctx->first_present_ns - ctx->init_start_ns : 0;
+    return 0;
+}
+
 BUMI_Window* BUMI_WindowCreate(const char* title, int x, int y, int w, int h, uint32_t flags) {
     BUMI_ClearError();
 
-    if (!ctx && !bumi_init_ctx()) {
+    if (!ctx && !bumi_init_ctx(0)) {
         return NULL;
     }
 
-    BUMI_Window* window = (BUMI_Window*) malloc(sizeof(BUMI_Window));
+    BUMI_Window* window = (BUMI_Window*) pool_alloc(&ctx->window_pool);
     if (!window) {
         set_error("Failed to allocate window");
         return NULL;
     }
 
     memset(window, 0, sizeof(BUMI_Window));
-    window->title = strdup(title ? title : "Bumi Window");
+    window->title = bumi_strdup(title ? title : "Bumi Window");
     if (!window->title) {
-        free(window);
+        pool_free(&ctx->window_pool, window);
         set_error("Failed to allocate window title");
         return NULL;
     }
@@ -131,33 +618,71 @@ BUMI_Window* BUMI_WindowCreate(const char* title, int x, int y, int w, int h, ui
     window->h = h;
     window->flags = flags;
     window->display_scale = 1.0f;
-    window->id = (BUMI_WindowID)(uintptr_t)window;
     window->last_pixel_w = w;
     window->last_pixel_h = h;
     window->min_w = window->min_h = 0;
     window->max_w = window->max_h = 0;
     window->min_aspect = window->max_aspect = 0.0f;
     window->renderers = NULL;
-    window->next = ctx->windows;
-    ctx->windows = window;
 
+    // A visual other than the parent's needs its own colormap and border
     XSetWindowAttributes attrs;
-    attrs.event_mask = StructureNotifyMask | KeyPressMask | KeyReleaseMask | Expose;
+    unsigned long mask = CWEventMask;
+    // With an input thread, input is selected on its own connection below
+    attrs.event_mask = StructureNotifyMask | ExposureMask;
+    if (!ctx->input_threaded) {
+        attrs.event_mask |= BUMI_INPUT_EVENT_MASK;
+    }
+    if (ctx->colormap != None) {
+        attrs.colormap = ctx->colormap;
+        attrs.border_pixel = 0;
+        mask |= CWColormap | CWBorderPixel;
+    }
     Window x11_window = XCreateWindow(
         ctx->dpy, ctx->root, x, y, w, h,
-        0, CopyFromParent, InputOutput, CopyFromParent,
-        CWEventMask, &attrs
+        0, ctx->depth, InputOutput, ctx->visual,
+        mask, &attrs
     );
 
     if (!x11_window) {
-        free(window->title);
-        free(window);
+        BUMI_internal_free(window->title);
+        pool_free(&ctx->window_pool, window);
         set_error("Failed to create X11 window");
         return NULL;
     }
+    window->id = ctx->next_window_id;
+    if (XSaveContext(ctx->dpy, x11_window, ctx->window_context, (XPointer) window) != 0 ||
+        XSaveContext(ctx->dpy, window->id, ctx->id_context, (XPointer) window) != 0) {
+        XDeleteContext(ctx->dpy, x11_window, ctx->window_context);
+        XDestroyWindow(ctx->dpy, x11_window);
+        BUMI_internal_free(window->title);
+        pool_free(&ctx->window_pool, window);
+        set_error("Failed to register X11 window");
+        return NULL;
+    }
+    if (ctx->input_threaded) {
+        // The window must exist on the server before the second connection can select on it
+        XSync(ctx->dpy, False);
+        XLockDisplay(ctx->input_dpy);
+        XSaveContext(ctx->input_dpy, x11_window, ctx->window_context, (XPointer)(uintptr_t) window->id);
+        XSelectInput(ctx->input_dpy, x11_window, BUMI_INPUT_EVENT_MASK);
+        XFlush(ctx->input_dpy);
+        XUnlockDisplay(ctx->input_dpy);
+    }
+    ctx->next_window_id++;
+    window->prev = NULL;
+    window->next = ctx->windows;
+    if (ctx->windows) {
+        ctx->windows->prev = window;
+    }
+    ctx->windows = window;
 
+    // Atoms are already interned, so none of this waits on the server
     XStoreName(ctx->dpy, x11_window, window->title);
-    XSetWMProtocols(ctx->dpy, x11_window, &ctx->wm_delete, 1);
+    XChangeProperty(ctx->dpy, x11_window, ctx->atoms[BUMI_ATOM_NET_WM_NAME], ctx->atoms[BUMI_ATOM_UTF8_STRING], 8,
+                    PropModeReplace, (const unsigned char*) window->title, (int) strlen(window->title));
+    XChangeProperty(ctx->dpy, x11_window, ctx->atoms[BUMI_ATOM_WM_PROTOCOLS], XA_ATOM, 32, PropModeReplace,
+                    (const unsigned char*) &ctx->atoms[BUMI_ATOM_WM_DELETE_WINDOW], 1);
 
     XMapWindow(ctx->dpy, x11_window);
 
@@ -171,6 +696,9 @@ BUMI_Window* BUMI_WindowCreate(const char* title, int x, int y, int w, int h, ui
     XFlush(ctx->dpy);
 
     window->backend_data = (void*)(uintptr_t)x11_window;
+    if (!ctx->first_window_ns) {
+        ctx->first_window_ns = monotonic_ns();
+    }
     return window;
 }
 
@@ -188,177 +716,4336 @@ void BUMI_WindowDestroy(BUMI_Window* window) {
 
     Window x11_window = (Window)(uintptr_t)window->backend_data;
     if (x11_window) {
-        BUMI_Window* prev = NULL;
-        BUMI_Window* current = ctx->windows;
-        while (current && current != window) {
-            prev = current;
-            current =  current->next;
-        }
-        if (current) {
-            if (prev) {
-                prev->next = current->next;
-            } else {
-                ctx->windows = current->next;
-            }
+        if (window->prev) {
+            window->prev->next = window->next;
+        } else {
+            ctx->windows = window->next;
+        }
+        if (window->next) {
+            window->next->prev = window->prev;
+        }
+        XDeleteContext(ctx->dpy, x11_window, ctx->window_context);
+        XDeleteContext(ctx->dpy, window->id, ctx->id_context);
+        if (ctx->input_threaded) {
+            XLockDisplay(ctx->input_dpy);
+            XDeleteContext(ctx->input_dpy, x11_window, ctx->window_context);
+            XUnlockDisplay(ctx->input_dpy);
+        } else if (ctx->mouse_window == window->id) {
+            ctx->mouse_window = 0;
         }
 
         XDestroyWindow(ctx->dpy, x11_window);
         XFlush(ctx->dpy);
     }
 
-    free(window->title);
-    free(window);
+    BUMI_internal_free(window->title);
+    pool_free(&ctx->window_pool, window);
 }
 
-BUMI_Renderer* BUMI_RendererCreate(BUMI_Window* window, int index, uint32_t flags) {
-    BUMI_ClearError();
+// Operations every renderer backend implements. The public BUMI_Render*
+// and BUMI_Texture* functions validate arguments and dispatch here
+typedef struct BUMI_RenderDriver {
+    const char* name;
+    uint32_t flags; // BUMI_RENDERER_* flags the backend satisfies
+    int (*create_renderer)(BUMI_Renderer* renderer);
+    void (*destroy_renderer)(BUMI_Renderer* renderer);
+    int (*clear)(BUMI_Renderer* renderer);
+    int (*fill_rects)(BUMI_Renderer* renderer, const BUMI_Rect* rects, int count);
+    // `colors` is NULL to fill every instance with the draw color
+    int (*fill_rects_instanced)(BUMI_Renderer* renderer, const BUMI_Rect* rects, const BUMI_Color* colors, int count);
+    int (*copy)(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Rect* src, const BUMI_Rect* dst);
+    // Many copies from one texture, each texel multiplied by `color`
+    int (*copy_batch)(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Rect* srcs, const BUMI_Rect* dsts,
+                      int count, const uint8_t color[4]);
+    // Triangle list; `indices` is NULL for vertices in order, `texture` NULL
+    // for plain colors. Arguments are already validated
+    int (*geometry)(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Vertex* vertices, int num_vertices,
+                    const int* indices, int num_indices);
+    void (*present)(BUMI_Renderer* renderer);
+    // Whether anything was drawn since the last present
+    bool (*dirty)(BUMI_Renderer* renderer);
+    // Present several dirty renderers of this driver in one pass
+    void (*present_many)(BUMI_Renderer** renderers, int count);
+    int (*create_texture)(BUMI_Texture* texture);
+    void (*destroy_texture)(BUMI_Texture* texture);
+    int (*update_texture)(BUMI_Texture* texture, const BUMI_Rect* rect, const void* pixels, int pitch);
+    int (*lock_texture)(BUMI_Texture* texture, const BUMI_Rect* rect, void** pixels, int* pitch);
+    void (*unlock_texture)(BUMI_Texture* texture);
+    int (*set_swap_interval)(BUMI_Renderer* renderer, int interval);
+    int (*get_present_timing)(BUMI_Renderer* renderer, BUMI_PresentTiming* timing);
+    // Re-show part of the last presented frame without the app redrawing it;
+    // returns -1 when the backend keeps no copy of the frame
+    int (*repaint)(BUMI_Renderer* renderer, const BUMI_Rect* area);
+    int (*set_target)(BUMI_Renderer* renderer, BUMI_Texture* texture);
+    int (*read_pixels)(BUMI_Renderer* renderer, const BUMI_Rect* rect, uint32_t format, void* pixels, int pitch);
+    // Hand the frame about to be presented to renderer->capture
+    void (*capture_frame)(BUMI_Renderer* renderer);
+    // Deliver frames still being read back and release capture resources
+    void (*end_capture)(BUMI_Renderer* renderer);
+} BUMI_RenderDriver;
 
-    if (!window) {
-        set_error("Invalid window for renderer creation");
-        return NULL;
-    }
+// Flags that pick a backend rather than configure one
+#define BUMI_RENDERER_DRIVER_FLAGS (BUMI_RENDERER_SOFTWARE | BUMI_RENDERER_ACCELERATED)
 
-    BUMI_Renderer* renderer = (BUMI_Renderer*) malloc(sizeof(BUMI_Renderer));
-    if (!renderer) {
-        set_error("Failed to allocate renderer");
-        return NULL;
-    }
+// Regions of the window touched since the last present. Past
+// BUMI_MAX_DAMAGE_RECTS, new rects are folded into the closest existing one
+#define BUMI_MAX_DAMAGE_RECTS 8
 
-    renderer->window = window;
-    renderer->next = window->renderers;
-    renderer->previous = NULL;
-    renderer->draw_color[0] = 0.0f; // Default black
-    renderer->draw_color[1] = 0.0f;
-    renderer->draw_color[2] = 0.0f;
-    renderer->draw_color[3] = 1.0f;
+typedef struct {
+    BUMI_Rect rects[BUMI_MAX_DAMAGE_RECTS];
+    int count;
+} BUMI_Damage;
 
-    int attribs[] = {GLX_RGBA, GLX_DOUBLEBUFFER, None};
-    XVisualInfo* vi = glXChooseVisual(ctx->dpy, ctx->screen, attribs);
-    if (!vi) {
-        free(renderer);
-        set_error("Failed to choose GLX visual");
-        return NULL;
+static BUMI_Rect rect_union(const BUMI_Rect* a, const BUMI_Rect* b) {
+    int x0 = a->x < b->x ? a->x : b->x;
+    int y0 = a->y < b->y ? a->y : b->y;
+    int x1 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y1 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+    BUMI_Rect out = {x0, y0, x1 - x0, y1 - y0};
+    return out;
+}
+
+static bool rect_intersect(const BUMI_Rect* a, const BUMI_Rect* b, BUMI_Rect* out) {
+    int x0 = a->x > b->x ? a->x : b->x;
+    int y0 = a->y > b->y ? a->y : b->y;
+    int x1 = a->x + a->w < b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y1 = a->y + a->h < b->y + b->h ? a->y + a->h : b->y + b->h;
+    if (x1 <= x0 || y1 <= y0) {
+        return false;
     }
+    out->x = x0;
+    out->y = y0;
+    out->w = x1 - x0;
+    out->h = y1 - y0;
+    return true;
+}
 
-    renderer->renderer_data = glXCreateContext(ctx->dpy, vi, NULL, True);
-    XFree(vi);
-    if (!renderer->renderer_data) {
-        free(renderer);
-        set_error("Failed to create GLX context");
-        return NULL;
+static void damage_add(BUMI_Damage* damage, const BUMI_Rect* rect, int w, int h) {
+    BUMI_Rect bounds = {0, 0, w, h};
+    BUMI_Rect area;
+    if (!rect_intersect(rect, &bounds, &area)) {
+        return;
     }
 
-    glXMakeCurrent(ctx->dpy, (Window)(uintptr_t)window->backend_data, (GLXContext) renderer->renderer_data);
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glXSwapBuffers(ctx->dpy, (Window)(uintptr_t)window->backend_data);
+    // Swallow it into a rect it overlaps, or append
+    for (int i = 0; i < damage->count; i++) {
+        BUMI_Rect overlap;
+        if (rect_intersect(&damage->rects[i], &area, &overlap)) {
+            damage->rects[i] = rect_union(&damage->rects[i], &area);
+            return;
+        }
+    }
+    if (damage->count < BUMI_MAX_DAMAGE_RECTS) {
+        damage->rects[damage->count++] = area;
+        return;
+    }
 
-    if (window->renderers) {
-        window->renderers->previous = renderer;
+    int best = 0;
+    long best_growth = -1;
+    for (int i = 0; i < damage->count; i++) {
+        BUMI_Rect merged = rect_union(&damage->rects[i], &area);
+        long growth = (long) merged.w * merged.h - (long) damage->rects[i].w * damage->rects[i].h;
+        if (best_growth < 0 || growth < best_growth) {
+            best = i;
+            best_growth = growth;
+        }
     }
-    window->renderers = renderer;
+    damage->rects[best] = rect_union(&damage->rects[best], &area);
+}
 
-    return renderer;
+static void damage_add_all(BUMI_Damage* damage, int w, int h) {
+    damage->rects[0].x = damage->rects[0].y = 0;
+    damage->rects[0].w = w;
+    damage->rects[0].h = h;
+    damage->count = 1;
 }
 
-void BUMI_RendererDestroy(BUMI_Renderer* renderer) {
-    if (!renderer) return;
+// Size of whatever the renderer currently draws into
+static void output_size(const BUMI_Renderer* renderer, int* w, int* h) {
+    if (renderer->target) {
+        *w = renderer->target->w;
+        *h = renderer->target->h;
+    } else {
+        *w = renderer->window->w;
+        *h = renderer->window->h;
+    }
+}
 
-    BUMI_ClearError();
+// Damage only tracks the window; draws into a render target never reach it
+static void damage_add_draw(BUMI_Damage* damage, const BUMI_Renderer* renderer, const BUMI_Rect* rect) {
+    if (!renderer->target) {
+        damage_add(damage, rect, renderer->window->w, renderer->window->h);
+    }
+}
 
-    if (renderer->previous) {
-        renderer->previous->next = renderer->next;
-    } else if (renderer->window) {
-        renderer->window->renderers = renderer->next;
+// One bounding rect for large draws, instead of folding each rect in
+static void damage_add_bounds(BUMI_Damage* damage, const BUMI_Renderer* renderer, const BUMI_Rect* rects, int count) {
+    if (renderer->target) {
+        return;
     }
-    if (renderer->next) {
-        renderer->next->previous = renderer->previous;
+    BUMI_Rect bounds = {0, 0, 0, 0};
+    for (int i = 0; i < count; i++) {
+        if (rects[i].w <= 0 || rects[i].h <= 0) {
+            continue;
+        }
+        bounds = bounds.w > 0 ? rect_union(&bounds, &rects[i]) : rects[i];
     }
-
-    if (renderer->renderer_data) {
-        glXDestroyContext(ctx->dpy, (GLXContext) renderer->renderer_data);
+    if (bounds.w > 0) {
+        damage_add(damage, &bounds, renderer->window->w, renderer->window->h);
     }
-    free(renderer);
 }
 
-int BUMI_SetRenderDrawColor(BUMI_Renderer* renderer, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
-    BUMI_ClearError();
-
-    if (!renderer || !renderer->renderer_data) {
-        set_error("Invalid renderer for setting draw color");
-        return -1;
+// Pixels a vertex array can touch
+static BUMI_Rect vertex_bounds(const BUMI_Vertex* vertices, int count) {
+    float x0 = vertices[0].x, y0 = vertices[0].y, x1 = x0, y1 = y0;
+    for (int i = 1; i < count; i++) {
+        if (vertices[i].x < x0) x0 = vertices[i].x;
+        if (vertices[i].x > x1) x1 = vertices[i].x;
+        if (vertices[i].y < y0) y0 = vertices[i].y;
+        if (vertices[i].y > y1) y1 = vertices[i].y;
     }
-
-    renderer->draw_color[0] = r / 255.0f;
-    renderer->draw_color[1] = g / 255.0f;
-    renderer->draw_color[2] = b / 255.0f;
-    renderer->draw_color[3] = a / 255.0f;
-    return 0;
+    BUMI_Rect bounds;
+    bounds.x = (int) floorf(x0);
+    bounds.y = (int) floorf(y0);
+    bounds.w = (int) ceilf(x1) - bounds.x;
+    bounds.h = (int) ceilf(y1) - bounds.y;
+    return bounds;
 }
 
-int BUMI_RenderClear(BUMI_Renderer* renderer) {
-    BUMI_ClearError();
-
-    if (!renderer || !renderer->renderer_data || !renderer->window) {
-        set_error("Invalid renderer for clearing");
-        return -1;
+static void damage_add_clear(BUMI_Damage* damage, const BUMI_Renderer* renderer) {
+    if (!renderer->target) {
+        damage_add_all(damage, renderer->window->w, renderer->window->h);
     }
-
-    glXMakeCurrent(ctx->dpy, (Window)(uintptr_t)renderer->window->backend_data, (GLXContext) renderer->renderer_data);
-    glClearColor(renderer->draw_color[0], renderer->draw_color[1], renderer->draw_color[2], renderer->draw_color[3]);
-    glClear(GL_COLOR_BUFFER_BIT);
-    return 0;
 }
 
-int BUMI_RenderFillRect(BUMI_Renderer* renderer, const BUMI_Rect* rect) {
-    BUMI_ClearError();
-
-    if (!renderer || !renderer->renderer_data || !renderer->window) {
-        set_error("Invalid renderer for drawing rectangle");
-        return -1;
+static void draw_color_bytes(const BUMI_Renderer* renderer, uint8_t color[4]) {
+    for (int i = 0; i < 4; i++) {
+        color[i] = (uint8_t)(renderer->draw_color[i] * 255.0f + 0.5f);
     }
+}
 
-    glXMakeCurrent(ctx->dpy, (Window)(uintptr_t)renderer->window->backend_data, (GLXContext) renderer->renderer_data);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho(0, renderer->window->w, renderer->window->h, 0, -1, 1);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+// === FRAME CAPTURE ===
 
-    float x = rect ? rect->x : 0;
-    float y = rect ? rect->y : 0;
-    float w = rect ? rect->w : renderer->window->w;
-    float h = rect ? rect->h : renderer->window->h;
+// Backends copy each presented frame into a free queue slot and move on; a
+// writer thread drains the queue into the file. With no free slot the frame
+// is dropped rather than making the render thread wait
+#define BUMI_CAPTURE_QUEUE 8
 
-    glColor4fv(renderer->draw_color);
-    glBegin(GL_QUADS);
-    glVertex2f(x, y);
-    glVertex2f(x + w, y);
-    glVertex2f(x + w, y + h);
-    glVertex2f(x, y + h);
-    glEnd();
+typedef struct {
+    uint8_t* pixels; // Top-down BGRA, capture->w x capture->h
+} BUMI_CaptureFrame;
 
-    return 0;
-}
+struct BUMI_Capture {
+    FILE* file;
+    int format;
+    int w, h;        // Window size when capture started; frames are clipped or padded to it
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    BUMI_CaptureFrame frames[BUMI_CAPTURE_QUEUE];
+    int head;        // Oldest queued frame
+    int count;
+    bool quit;
+    bool write_failed;
+    uint64_t captured, written, dropped;
+    uint8_t* yuv;    // Writer scratch for Y4M conversion
+};
 
-void BUMI_RenderPresent(BUMI_Renderer* renderer) {
-    BUMI_ClearError();
+// BT.601 full range, matching the "C420jpeg" Y4M tag
+static void capture_write_y4m(BUMI_Capture* capture, const BUMI_CaptureFrame* frame) {
+    int w = capture->w;
+    int h = capture->h;
+    int cw = (w + 1) / 2;
+    int ch = (h + 1) / 2;
+    uint8_t* y_plane = capture->yuv;
+    uint8_t* u_plane = y_plane + (size_t) w * h;
+    uint8_t* v_plane = u_plane + (size_t) cw * ch;
 
-    if (!renderer || !renderer->renderer_data || !renderer->window) {
-        set_error("Invalid renderer for presenting");
-        return;
+    for (int y = 0; y < h; y++) {
+        const uint8_t* src = frame->pixels + (size_t) y * w * 4;
+        for (int x = 0; x < w; x++) {
+            const uint8_t* p = src + x * 4;
+            y_plane[(size_t) y * w + x] = (uint8_t)((77 * p[2] + 150 * p[1] + 29 * p[0] + 128) >> 8);
+        }
+    }
+    for (int y = 0; y < ch; y++) {
+        const uint8_t* src = frame->pixels + (size_t)(y * 2) * w * 4;
+        for (int x = 0; x < cw; x++) {
+            const uint8_t* p = src + (x * 2) * 4;
+            int r = p[2], g = p[1], b = p[0];
+            u_plane[(size_t) y * cw + x] = (uint8_t)((-43 * r - 85 * g + 128 * b + 32768 + 128) >> 8);
+            v_plane[(size_t) y * cw + x] = (uint8_t)((128 * r - 107 * g - 21 * b + 32768 + 128) >> 8);
+        }
     }
 
-    glXMakeCurrent(ctx->dpy, (Window)(uintptr_t)renderer->window->backend_data, (GLXContext) renderer->renderer_data);
-    glXSwapBuffers(ctx->dpy, (Window)(uintptr_t)renderer->window->backend_data);
+    size_t size = (size_t) w * h + (size_t) cw * ch * 2;
+    if (fputs("FRAME\n", capture->file) == EOF || fwrite(capture->yuv, 1, size, capture->file) != size) {
+        capture->write_failed = true;
+    }
 }
 
-void BUMI_Delay(uint32_t ms) {
-    usleep(ms * 1000);
+static void capture_write_raw(BUMI_Capture* capture, const BUMI_CaptureFrame* frame) {
+    size_t size = (size_t) capture->w * capture->h * 4;
+    if (fwrite(frame->pixels, 1, size, capture->file) != size) {
+        capture->write_failed = true;
+    }
 }
 
-static BUMI_Keycode x11_to_bumi_keycode(KeySym keysym) {
-    switch (keysym) {
+static void* capture_writer_main(void* arg) {
+    BUMI_Capture* capture = (BUMI_Capture*) arg;
+
+    pthread_mutex_lock(&capture->lock);
+    for (;;) {
+        while (!capture->quit && capture->count == 0) {
+            pthread_cond_wait(&capture->ready, &capture->lock);
+        }
+        if (capture->count == 0) {
+            break;
+        }
+        BUMI_CaptureFrame* frame = &capture->frames[capture->head];
+        pthread_mutex_unlock(&capture->lock);
+
+        if (!capture->write_failed) {
+            if (capture->format == BUMI_CAPTURE_Y4M) {
+                capture_write_y4m(capture, frame);
+            } else {
+                capture_write_raw(capture, frame);
+            }
+        }
+
+        pthread_mutex_lock(&capture->lock);
+        capture->head = (capture->head + 1) % BUMI_CAPTURE_QUEUE;
+        capture->count--;
+        capture->written++;
+    }
+    pthread_mutex_unlock(&capture->lock);
+    return NULL;
+}
+
+// Free slot for the next frame, or NULL (and a drop) when the writer is behind
+static BUMI_CaptureFrame* capture_acquire(BUMI_Capture* capture) {
+    BUMI_CaptureFrame* frame = NULL;
+    pthread_mutex_lock(&capture->lock);
+    if (capture->count < BUMI_CAPTURE_QUEUE) {
+        frame = &capture->frames[(capture->head + capture->count) % BUMI_CAPTURE_QUEUE];
+    } else {
+        capture->dropped++;
+    }
+    pthread_mutex_unlock(&capture->lock);
+    return frame;
+}
+
+static void capture_submit(BUMI_Capture* capture) {
+    pthread_mutex_lock(&capture->lock);
+    capture->count++;
+    capture->captured++;
+    pthread_cond_signal(&capture->ready);
+    pthread_mutex_unlock(&capture->lock);
+}
+
+static void capture_drop(BUMI_Capture* capture) {
+    pthread_mutex_lock(&capture->lock);
+    capture->dropped++;
+    pthread_mutex_unlock(&capture->lock);
+}
+
+// Copy a `w` x `h` BGRA frame into the slot, blacking out what it doesn't
+// cover. Bottom-up sources (GL window readback) are flipped on the way
+static void capture_fill(BUMI_Capture* capture, BUMI_CaptureFrame* frame, const uint8_t* pixels, int pitch,
+                         int w, int h, bool bottom_up) {
+    size_t row = (size_t) capture->w * 4;
+    if (w < capture->w || h < capture->h) {
+        memset(frame->pixels, 0, row * capture->h);
+    }
+    for (int y = 0; y < h; y++) {
+        const uint8_t* src = pixels + (size_t)(bottom_up ? h - 1 - y : y) * pitch;
+        memcpy(frame->pixels + (size_t) y * row, src, (size_t) w * 4);
+    }
+}
+
+// === GLX RENDERER ===
+
+// Vertex layout of the pending batch: position, texture coordinates and
+// packed RGBA color, so draw color changes never force a flush
+typedef struct {
+    float x, y;
+    float u, v;
+    uint8_t color[4];
+} BUMI_GLVertex;
+
+// The core backend streams each flush through one segment of a VBO ring;
+// a segment holds whole quads so chunked draws never split one
+#define BUMI_GL_VBO_RING 3
+#define BUMI_GL_VBO_SEGMENT_VERTICES 6144
+#define BUMI_GL_CAPTURE_RING 3
+
+// Backend data behind BUMI_Renderer::renderer_data for the GLX renderer
+typedef struct {
+    GLXContext context;
+    BUMI_GLVertex* vertices;   // Pending triangles, flushed as one draw call
+    int vertex_count;
+    int vertex_capacity;
+    GLuint batch_texture;      // Texture bound by the pending batch, 0 for fills
+    int viewport_w, viewport_h; // Size the projection was last built for
+    BUMI_Texture* viewport_target; // Output the projection was last built for
+    bool retained;             // Back buffer is never swapped away (partial present)
+    BUMI_Damage damage;
+    int swap_interval;         // As set by the app
+    int applied_interval;      // As last handed to GLX; BUMI_RenderPresentAll lowers it
+
+    // Core profile only (opengl_core driver)
+    bool core;
+    GLuint program;
+    GLint scale_location, offset_location, textured_location;
+    GLuint vao;
+    GLuint vbo;
+    BUMI_GLVertex* mapped;     // Persistent mapping of the VBO ring, NULL when orphaning
+    GLsync fences[BUMI_GL_VBO_RING]; // Last draw reading each ring segment
+    int vbo_segment;
+    GLuint instance_program;   // Instanced rect fills
+    GLint instance_scale_location, instance_offset_location;
+    GLuint instance_vao;
+    GLuint corner_vbo;         // Unit quad shared by every instance
+    GLuint instance_vbo;       // Rects followed by colors, re-specified per draw
+
+    // Frame capture readback ring
+    GLuint capture_pbos[BUMI_GL_CAPTURE_RING];
+    GLsync capture_fences[BUMI_GL_CAPTURE_RING];
+    int capture_sizes[BUMI_GL_CAPTURE_RING][2];
+    int capture_head;          // Oldest readback in flight
+    int capture_pending;
+    uint8_t* capture_staging;  // Synchronous fallback without PBOs or fences
+} BUMI_GLRenderData;
+
+#define BUMI_GL_BATCH_INITIAL_VERTICES 6144
+#define BUMI_GL_PBO_RING 3
+
+// GL entry points above OpenGL 1.1 are resolved at runtime through GLX
+typedef struct {
+    bool loaded;
+    bool has_pbo;
+    PFNGLGENBUFFERSPROC GenBuffers;
+    PFNGLDELETEBUFFERSPROC DeleteBuffers;
+    PFNGLBINDBUFFERPROC BindBuffer;
+    PFNGLBUFFERDATAPROC BufferData;
+    PFNGLMAPBUFFERPROC MapBuffer;
+    PFNGLUNMAPBUFFERPROC UnmapBuffer;
+    PFNGLXSWAPINTERVALEXTPROC SwapIntervalEXT;   // Per-drawable swap control
+    PFNGLXSWAPINTERVALMESAPROC SwapIntervalMESA; // Current-drawable swap control
+    PFNGLXGETSYNCVALUESOMLPROC GetSyncValuesOML;
+    PFNGLXWAITFORSBCOMLPROC WaitForSbcOML;
+    PFNGLXCOPYSUBBUFFERMESAPROC CopySubBufferMESA;
+    bool has_fbo;
+    PFNGLGENFRAMEBUFFERSPROC GenFramebuffers;
+    PFNGLDELETEFRAMEBUFFERSPROC DeleteFramebuffers;
+    PFNGLBINDFRAMEBUFFERPROC BindFramebuffer;
+    PFNGLFRAMEBUFFERTEXTURE2DPROC FramebufferTexture2D;
+    PFNGLCHECKFRAMEBUFFERSTATUSPROC CheckFramebufferStatus;
+    bool has_sync;
+    PFNGLFENCESYNCPROC FenceSync;
+    PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+    PFNGLDELETESYNCPROC DeleteSync;
+
+    // Shader pipeline for the core profile backend
+    bool core_loaded;
+    bool has_core;
+    bool has_buffer_storage;
+    PFNGLGETSTRINGIPROC GetStringi;
+    PFNGLCREATESHADERPROC CreateShader;
+    PFNGLSHADERSOURCEPROC ShaderSource;
+    PFNGLCOMPILESHADERPROC CompileShader;
+    PFNGLGETSHADERIVPROC GetShaderiv;
+    PFNGLGETSHADERINFOLOGPROC GetShaderInfoLog;
+    PFNGLDELETESHADERPROC DeleteShader;
+    PFNGLCREATEPROGRAMPROC CreateProgram;
+    PFNGLATTACHSHADERPROC AttachShader;
+    PFNGLLINKPROGRAMPROC LinkProgram;
+    PFNGLGETPROGRAMIVPROC GetProgramiv;
+    PFNGLGETPROGRAMINFOLOGPROC GetProgramInfoLog;
+    PFNGLDELETEPROGRAMPROC DeleteProgram;
+    PFNGLUSEPROGRAMPROC UseProgram;
+    PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+    PFNGLUNIFORM1IPROC Uniform1i;
+    PFNGLUNIFORM2FPROC Uniform2f;
+    PFNGLGENVERTEXARRAYSPROC GenVertexArrays;
+    PFNGLBINDVERTEXARRAYPROC BindVertexArray;
+    PFNGLDELETEVERTEXARRAYSPROC DeleteVertexArrays;
+    PFNGLVERTEXATTRIBPOINTERPROC VertexAttribPointer;
+    PFNGLENABLEVERTEXATTRIBARRAYPROC EnableVertexAttribArray;
+    PFNGLBUFFERSUBDATAPROC BufferSubData;
+    PFNGLBUFFERSTORAGEPROC BufferStorage;
+    PFNGLMAPBUFFERRANGEPROC MapBufferRange;
+    PFNGLDRAWARRAYSINSTANCEDPROC DrawArraysInstanced;
+    PFNGLVERTEXATTRIBDIVISORPROC VertexAttribDivisor;
+    PFNGLDISABLEVERTEXATTRIBARRAYPROC DisableVertexAttribArray;
+    PFNGLVERTEXATTRIB4FPROC VertexAttrib4f;
+} BUMI_GLFunctions;
+
+static BUMI_GLFunctions gl;
+
+static void* gl_get_proc(const char* name) {
+    return (void*) glXGetProcAddressARB((const GLubyte*) name);
+}
+
+// Exact token match, so an extension is not mistaken for a longer one
+static bool has_extension(const char* extensions, const char* name) {
+    size_t length = strlen(name);
+    const char* at = extensions;
+    while (at && (at = strstr(at, name)) != NULL) {
+        if ((at == extensions || at[-1] == ' ') && (at[length] == ' ' || at[length] == '\0')) {
+            return true;
+        }
+        at += length;
+    }
+    return false;
+}
+
+static void gl_load_functions(void) {
+    if (gl.loaded) return;
+
+    const char* glx_extensions = glXQueryExtensionsString(ctx->dpy, ctx->screen);
+    if (has_extension(glx_extensions, "GLX_EXT_swap_control")) {
+        gl.SwapIntervalEXT = (PFNGLXSWAPINTERVALEXTPROC) gl_get_proc("glXSwapIntervalEXT");
+    }
+    if (has_extension(glx_extensions, "GLX_MESA_swap_control")) {
+        gl.SwapIntervalMESA = (PFNGLXSWAPINTERVALMESAPROC) gl_get_proc("glXSwapIntervalMESA");
+    }
+    if (has_extension(glx_extensions, "GLX_MESA_copy_sub_buffer")) {
+        gl.CopySubBufferMESA = (PFNGLXCOPYSUBBUFFERMESAPROC) gl_get_proc("glXCopySubBufferMESA");
+    }
+    if (has_extension(glx_extensions, "GLX_OML_sync_control")) {
+        gl.GetSyncValuesOML = (PFNGLXGETSYNCVALUESOMLPROC) gl_get_proc("glXGetSyncValuesOML");
+        gl.WaitForSbcOML = (PFNGLXWAITFORSBCOMLPROC) gl_get_proc("glXWaitForSbcOML");
+    }
+
+    gl.GenBuffers = (PFNGLGENBUFFERSPROC) gl_get_proc("glGenBuffers");
+    gl.DeleteBuffers = (PFNGLDELETEBUFFERSPROC) gl_get_proc("glDeleteBuffers");
+    gl.BindBuffer = (PFNGLBINDBUFFERPROC) gl_get_proc("glBindBuffer");
+    gl.BufferData = (PFNGLBUFFERDATAPROC) gl_get_proc("glBufferData");
+    gl.MapBuffer = (PFNGLMAPBUFFERPROC) gl_get_proc("glMapBuffer");
+    gl.UnmapBuffer = (PFNGLUNMAPBUFFERPROC) gl_get_proc("glUnmapBuffer");
+
+    const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+    const char* version = (const char*) glGetString(GL_VERSION);
+    bool pbo_ext = has_extension(extensions, "GL_ARB_pixel_buffer_object") ||
+                   has_extension(extensions, "GL_EXT_pixel_buffer_object");
+    bool gl21 = version && (version[0] > '2' || (version[0] == '2' && version[2] >= '1'));
+    gl.has_pbo = (pbo_ext || gl21) && gl.GenBuffers && gl.DeleteBuffers && gl.BindBuffer &&
+                 gl.BufferData && gl.MapBuffer && gl.UnmapBuffer;
+
+    // Core/ARB framebuffer objects share entry points; EXT ones carry a suffix
+    bool gl30 = version && version[0] >= '3';
+    const char* suffix = NULL;
+    if (gl30 || has_extension(extensions, "GL_ARB_framebuffer_object")) {
+        suffix = "";
+    } else if (has_extension(extensions, "GL_EXT_framebuffer_object")) {
+        suffix = "EXT";
+    }
+    if (suffix) {
+        char name[64];
+        snprintf(name, sizeof(name), "glGenFramebuffers%s", suffix);
+        gl.GenFramebuffers = (PFNGLGENFRAMEBUFFERSPROC) gl_get_proc(name);
+        snprintf(name, sizeof(name), "glDeleteFramebuffers%s", suffix);
+        gl.DeleteFramebuffers = (PFNGLDELETEFRAMEBUFFERSPROC) gl_get_proc(name);
+        snprintf(name, sizeof(name), "glBindFramebuffer%s", suffix);
+        gl.BindFramebuffer = (PFNGLBINDFRAMEBUFFERPROC) gl_get_proc(name);
+        snprintf(name, sizeof(name), "glFramebufferTexture2D%s", suffix);
+        gl.FramebufferTexture2D = (PFNGLFRAMEBUFFERTEXTURE2DPROC) gl_get_proc(name);
+        snprintf(name, sizeof(name), "glCheckFramebufferStatus%s", suffix);
+        gl.CheckFramebufferStatus = (PFNGLCHECKFRAMEBUFFERSTATUSPROC) gl_get_proc(name);
+    }
+    gl.has_fbo = gl.GenFramebuffers && gl.DeleteFramebuffers && gl.BindFramebuffer &&
+                 gl.FramebufferTexture2D && gl.CheckFramebufferStatus;
+
+    bool gl32 = version && (version[0] > '3' || (version[0] == '3' && version[2] >= '2'));
+    if (gl32 || has_extension(extensions, "GL_ARB_sync")) {
+        gl.FenceSync = (PFNGLFENCESYNCPROC) gl_get_proc("glFenceSync");
+        gl.ClientWaitSync = (PFNGLCLIENTWAITSYNCPROC) gl_get_proc("glClientWaitSync");
+        gl.DeleteSync = (PFNGLDELETESYNCPROC) gl_get_proc("glDeleteSync");
+    }
+    gl.has_sync = gl.FenceSync && gl.ClientWaitSync && gl.DeleteSync;
+    gl.loaded = true;
+}
+
+// Core contexts only list extensions through glGetStringi
+static bool has_core_extension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*) gl.GetStringi(GL_EXTENSIONS, (GLuint) i);
+        if (extension && strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Needs a current core context
+static void gl_load_core_functions(void) {
+    if (gl.core_loaded) return;
+
+    gl.GetStringi = (PFNGLGETSTRINGIPROC) gl_get_proc("glGetStringi");
+    gl.CreateShader = (PFNGLCREATESHADERPROC) gl_get_proc("glCreateShader");
+    gl.ShaderSource = (PFNGLSHADERSOURCEPROC) gl_get_proc("glShaderSource");
+    gl.CompileShader = (PFNGLCOMPILESHADERPROC) gl_get_proc("glCompileShader");
+    gl.GetShaderiv = (PFNGLGETSHADERIVPROC) gl_get_proc("glGetShaderiv");
+    gl.GetShaderInfoLog = (PFNGLGETSHADERINFOLOGPROC) gl_get_proc("glGetShaderInfoLog");
+    gl.DeleteShader = (PFNGLDELETESHADERPROC) gl_get_proc("glDeleteShader");
+    gl.CreateProgram = (PFNGLCREATEPROGRAMPROC) gl_get_proc("glCreateProgram");
+    gl.AttachShader = (PFNGLATTACHSHADERPROC) gl_get_proc("glAttachShader");
+    gl.LinkProgram = (PFNGLLINKPROGRAMPROC) gl_get_proc("glLinkProgram");
+    gl.GetProgramiv = (PFNGLGETPROGRAMIVPROC) gl_get_proc("glGetProgramiv");
+    gl.GetProgramInfoLog = (PFNGLGETPROGRAMINFOLOGPROC) gl_get_proc("glGetProgramInfoLog");
+    gl.DeleteProgram = (PFNGLDELETEPROGRAMPROC) gl_get_proc("glDeleteProgram");
+    gl.UseProgram = (PFNGLUSEPROGRAMPROC) gl_get_proc("glUseProgram");
+    gl.GetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC) gl_get_proc("glGetUniformLocation");
+    gl.Uniform1i = (PFNGLUNIFORM1IPROC) gl_get_proc("glUniform1i");
+    gl.Uniform2f = (PFNGLUNIFORM2FPROC) gl_get_proc("glUniform2f");
+    gl.GenVertexArrays = (PFNGLGENVERTEXARRAYSPROC) gl_get_proc("glGenVertexArrays");
+    gl.BindVertexArray = (PFNGLBINDVERTEXARRAYPROC) gl_get_proc("glBindVertexArray");
+    gl.DeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSPROC) gl_get_proc("glDeleteVertexArrays");
+    gl.VertexAttribPointer = (PFNGLVERTEXATTRIBPOINTERPROC) gl_get_proc("glVertexAttribPointer");
+    gl.EnableVertexAttribArray = (PFNGLENABLEVERTEXATTRIBARRAYPROC) gl_get_proc("glEnableVertexAttribArray");
+    gl.BufferSubData = (PFNGLBUFFERSUBDATAPROC) gl_get_proc("glBufferSubData");
+    gl.MapBufferRange = (PFNGLMAPBUFFERRANGEPROC) gl_get_proc("glMapBufferRange");
+    gl.DrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC) gl_get_proc("glDrawArraysInstanced");
+    gl.VertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC) gl_get_proc("glVertexAttribDivisor");
+    gl.DisableVertexAttribArray = (PFNGLDISABLEVERTEXATTRIBARRAYPROC) gl_get_proc("glDisableVertexAttribArray");
+    gl.VertexAttrib4f = (PFNGLVERTEXATTRIB4FPROC) gl_get_proc("glVertexAttrib4f");
+    gl.has_core = gl.GetStringi && gl.CreateShader && gl.ShaderSource && gl.CompileShader && gl.GetShaderiv &&
+                  gl.GetShaderInfoLog && gl.DeleteShader && gl.CreateProgram && gl.AttachShader &&
+                  gl.LinkProgram && gl.GetProgramiv && gl.GetProgramInfoLog && gl.DeleteProgram &&
+                  gl.UseProgram && gl.GetUniformLocation && gl.Uniform1i && gl.Uniform2f &&
+                  gl.GenVertexArrays && gl.BindVertexArray && gl.DeleteVertexArrays && gl.VertexAttribPointer &&
+                  gl.EnableVertexAttribArray && gl.BufferSubData && gl.MapBufferRange && gl.has_sync &&
+                  gl.DrawArraysInstanced && gl.VertexAttribDivisor &&
+                  gl.DisableVertexAttribArray && gl.VertexAttrib4f && gl.GenBuffers && gl.BindBuffer &&
+                  gl.BufferData;
+
+    // Persistent mapping needs 4.4 or ARB_buffer_storage; otherwise orphan
+    if (gl.has_core && has_core_extension("GL_ARB_buffer_storage")) {
+        gl.BufferStorage = (PFNGLBUFFERSTORAGEPROC) gl_get_proc("glBufferStorage");
+    }
+    gl.has_buffer_storage = gl.BufferStorage != NULL;
+    gl.core_loaded = true;
+}
+
+// What this thread last bound through gl_make_current
+static __thread GLXContext gl_current_context = NULL;
+static __thread GLXDrawable gl_current_drawable = None;
+static __thread BUMI_Renderer* gl_current_renderer = NULL;
+
+static void gl_flush_batch(BUMI_Renderer* renderer);
+
+// glXMakeCurrent can be a full context switch inside the driver, so skip it
+// when this thread already has the context bound to the same window.
+// Switching submits the outgoing renderer's batch first and glXMakeCurrent
+// flushes its context, so only the current renderer can hold GL commands
+// the server has not seen. Batches still queue without binding a context,
+// so any renderer may hold vertices that were never submitted
+static void gl_make_current(BUMI_Renderer* renderer) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    GLXDrawable drawable = (Window)(uintptr_t)renderer->window->backend_data;
+    if (gl_current_context == data->context && gl_current_drawable == drawable) {
+        return;
+    }
+    if (gl_current_renderer && gl_current_renderer != renderer) {
+        gl_flush_batch(gl_current_renderer);
+    }
+    glXMakeCurrent(ctx->dpy, drawable, data->context);
+    gl_current_context = data->context;
+    gl_current_drawable = drawable;
+    gl_current_renderer = renderer;
+}
+
+static void gl_release_context(GLXContext context) {
+    if (gl_current_context == context) {
+        glXMakeCurrent(ctx->dpy, None, NULL);
+        gl_current_context = NULL;
+        gl_current_drawable = None;
+        gl_current_renderer = NULL;
+    }
+}
+
+// All contexts a driver creates join one share group, so textures and
+// buffers upload once and work in every window. Any live context of the
+// same kind can seed a new one
+static GLXContext gl_share_context(bool core) {
+    for (BUMI_Window* window = ctx->windows; window; window = window->next) {
+        for (BUMI_Renderer* renderer = window->renderers; renderer; renderer = renderer->next) {
+            if (!(renderer->driver->flags & BUMI_RENDERER_ACCELERATED)) {
+                continue;
+            }
+            BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+            if (data->core == core) {
+                return data->context;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Rebuild the projection only when the output size changed since the last draw
+static void gl_update_viewport(BUMI_Renderer* renderer) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    int w, h;
+    output_size(renderer, &w, &h);
+    if (data->viewport_w == w && data->viewport_h == h && data->viewport_target == renderer->target) {
+        return;
+    }
+
+    data->viewport_w = w;
+    data->viewport_h = h;
+    data->viewport_target = renderer->target;
+    damage_add_clear(&data->damage, renderer);
+    glViewport(0, 0, w, h);
+    if (data->core) {
+        // Pixel coordinates to clip space; targets keep row 0 at the top
+        float sy = renderer->target ? 2.0f / h : -2.0f / h;
+        float oy = renderer->target ? -1.0f : 1.0f;
+        gl.UseProgram(data->instance_program);
+        gl.Uniform2f(data->instance_scale_location, 2.0f / w, sy);
+        gl.Uniform2f(data->instance_offset_location, -1.0f, oy);
+        gl.UseProgram(data->program);
+        gl.Uniform2f(data->scale_location, 2.0f / w, sy);
+        gl.Uniform2f(data->offset_location, -1.0f, oy);
+        return;
+    }
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    if (renderer->target) {
+        // Keep row 0 of a target texture at the top, like uploaded textures
+        glOrtho(0, w, 0, h, -1, 1);
+    } else {
+        glOrtho(0, w, h, 0, -1, 1);
+    }
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+// Core profile: copy the batch into the VBO ring and draw it from there,
+// one glDrawArrays per segment it spans
+static void gl3_draw_batch(BUMI_GLRenderData* data) {
+    if (data->batch_texture) {
+        glEnable(GL_BLEND);
+        glBindTexture(GL_TEXTURE_2D, data->batch_texture);
+    }
+    gl.Uniform1i(data->textured_location, data->batch_texture != 0);
+
+    for (int first = 0; first < data->vertex_count; first += BUMI_GL_VBO_SEGMENT_VERTICES) {
+        int count = data->vertex_count - first;
+        if (count > BUMI_GL_VBO_SEGMENT_VERTICES) {
+            count = BUMI_GL_VBO_SEGMENT_VERTICES;
+        }
+        size_t size = (size_t) count * sizeof(BUMI_GLVertex);
+
+        if (data->mapped) {
+            // Wait until the GPU is done with the draw that last read this segment
+            GLsync* fence = &data->fences[data->vbo_segment];
+            if (*fence) {
+                gl.ClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+                gl.DeleteSync(*fence);
+            }
+            int base = data->vbo_segment * BUMI_GL_VBO_SEGMENT_VERTICES;
+            memcpy(data->mapped + base, data->vertices + first, size);
+            glDrawArrays(GL_TRIANGLES, base, count);
+            *fence = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            data->vbo_segment = (data->vbo_segment + 1) % BUMI_GL_VBO_RING;
+        } else {
+            // Orphan the store so the driver hands back fresh memory instead
+            // of stalling on draws still in flight
+            gl.BufferData(GL_ARRAY_BUFFER, BUMI_GL_VBO_SEGMENT_VERTICES * sizeof(BUMI_GLVertex), NULL, GL_STREAM_DRAW);
+            gl.BufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr) size, data->vertices + first);
+            glDrawArrays(GL_TRIANGLES, 0, count);
+        }
+    }
+
+    if (data->batch_texture) {
+        glDisable(GL_BLEND);
+    }
+}
+
+// Submit every pending triangle as a single glDrawArrays call
+static void gl_flush_batch(BUMI_Renderer* renderer) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    if (data->vertex_count == 0) {
+        return;
+    }
+
+    gl_make_current(renderer);
+    gl_update_viewport(renderer);
+
+    if (data->core) {
+        gl3_draw_batch(data);
+        data->vertex_count = 0;
+        return;
+    }
+
+    if (data->batch_texture) {
+        glEnable(GL_TEXTURE_2D);
+        glEnable(GL_BLEND);
+        glBindTexture(GL_TEXTURE_2D, data->batch_texture);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(BUMI_GLVertex), &data->vertices[0].u);
+    }
+
+    glVertexPointer(2, GL_FLOAT, sizeof(BUMI_GLVertex), &data->vertices[0].x);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BUMI_GLVertex), data->vertices[0].color);
+    glDrawArrays(GL_TRIANGLES, 0, data->vertex_count);
+
+    if (data->batch_texture) {
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisable(GL_BLEND);
+        glDisable(GL_TEXTURE_2D);
+    }
+    data->vertex_count = 0;
+}
+
+static int gl_reserve_vertices(BUMI_GLRenderData* data, int count) {
+    if (data->vertex_count + count <= data->vertex_capacity) {
+        return 1;
+    }
+
+    int capacity = data->vertex_capacity ? data->vertex_capacity : BUMI_GL_BATCH_INITIAL_VERTICES;
+    while (capacity < data->vertex_count + count) {
+        capacity *= 2;
+    }
+
+    BUMI_GLVertex* vertices = (BUMI_GLVertex*) BUMI_internal_realloc(data->vertices, capacity * sizeof(BUMI_GLVertex));
+    if (!vertices) {
+        return 0;
+    }
+    data->vertices = vertices;
+    data->vertex_capacity = capacity;
+    return 1;
+}
+
+// Make room for `count` vertices drawn with `texture`, flushing first if the
+// pending batch uses a different one
+static int gl_begin_batch(BUMI_Renderer* renderer, GLuint texture, int count) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    if (data->batch_texture != texture) {
+        gl_flush_batch(renderer);
+        data->batch_texture = texture;
+    }
+    if (!gl_reserve_vertices(data, count)) {
+        set_error("Failed to grow render batch");
+        return 0;
+    }
+    return 1;
+}
+
+static void gl_queue_quad(BUMI_GLRenderData* data, const uint8_t color[4], float x, float y, float w, float h,
+                          float u0, float v0, float u1, float v1) {
+    BUMI_GLVertex* v = &data->vertices[data->vertex_count];
+    const float xs[6] = {x, x + w, x + w, x, x + w, x};
+    const float ys[6] = {y, y, y + h, y, y + h, y + h};
+    const float us[6] = {u0, u1, u1, u0, u1, u0};
+    const float vs[6] = {v0, v0, v1, v0, v1, v1};
+    for (int i = 0; i < 6; i++) {
+        v[i].x = xs[i];
+        v[i].y = ys[i];
+        v[i].u = us[i];
+        v[i].v = vs[i];
+        memcpy(v[i].color, color, 4);
+    }
+    data->vertex_count += 6;
+}
+
+static void gl_queue_rect(BUMI_GLRenderData* data, const uint8_t color[4], float x, float y, float w, float h) {
+    gl_queue_quad(data, color, x, y, w, h, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+
+static int gl_create_renderer(BUMI_Renderer* renderer) {
+    BUMI_Window* window = renderer->window;
+    if (!ctx->fbconfig) {
+        set_error("Display has no usable GLX framebuffer config");
+        return -1;
+    }
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) BUMI_internal_calloc(1, sizeof(BUMI_GLRenderData));
+    if (!data) {
+        set_error("Failed to allocate renderer data");
+        return -1;
+    }
+
+    data->context = glXCreateNewContext(ctx->dpy, ctx->fbconfig, GLX_RGBA_TYPE, gl_share_context(false), True);
+    if (!data->context) {
+        BUMI_internal_free(data);
+        set_error("Failed to create GLX context");
+        return -1;
+    }
+    renderer->renderer_data = data;
+
+    gl_make_current(renderer);
+    gl_load_functions();
+    gl_update_viewport(renderer);
+    data->retained = (renderer->flags & BUMI_RENDERER_PARTIAL_PRESENT) && gl.CopySubBufferMESA;
+    data->swap_interval = data->applied_interval = 1;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glXSwapBuffers(ctx->dpy, (Window)(uintptr_t)window->backend_data);
+    return 0;
+}
+
+static void gl_destroy_renderer(BUMI_Renderer* renderer) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    if (data->context) {
+        // Buffers, programs and fences belong to the share group and would
+        // outlive this context
+        if (data->core && gl.has_core) {
+            gl_make_current(renderer);
+            for (int i = 0; i < BUMI_GL_VBO_RING; i++) {
+                if (data->fences[i]) {
+                    gl.DeleteSync(data->fences[i]);
+                }
+            }
+            GLuint buffers[3] = {data->vbo, data->corner_vbo, data->instance_vbo};
+            GLuint arrays[2] = {data->vao, data->instance_vao};
+            gl.DeleteBuffers(3, buffers);
+            gl.DeleteVertexArrays(2, arrays);
+            gl.DeleteProgram(data->program);
+            gl.DeleteProgram(data->instance_program);
+        }
+        gl_release_context(data->context);
+        glXDestroyContext(ctx->dpy, data->context);
+    }
+    BUMI_internal_free(data->vertices);
+    BUMI_internal_free(data);
+}
+
+static const char* gl3_vertex_shader =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 a_position;\n"
+    "layout(location = 1) in vec2 a_texcoord;\n"
+    "layout(location = 2) in vec4 a_color;\n"
+    "uniform vec2 u_scale;\n"
+    "uniform vec2 u_offset;\n"
+    "out vec2 v_texcoord;\n"
+    "out vec4 v_color;\n"
+    "void main() {\n"
+    "    v_texcoord = a_texcoord;\n"
+    "    v_color = a_color;\n"
+    "    gl_Position = vec4(a_position * u_scale + u_offset, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* gl3_fragment_shader =
+    "#version 330 core\n"
+    "in vec2 v_texcoord;\n"
+    "in vec4 v_color;\n"
+    "uniform sampler2D u_texture;\n"
+    "uniform bool u_textured;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    frag_color = u_textured ? texture(u_texture, v_texcoord) * v_color : v_color;\n"
+    "}\n";
+
+static const char* gl3_instance_vertex_shader =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 a_corner;\n"
+    "layout(location = 1) in vec4 a_rect;\n"
+    "layout(location = 2) in vec4 a_color;\n"
+    "uniform vec2 u_scale;\n"
+    "uniform vec2 u_offset;\n"
+    "out vec4 v_color;\n"
+    "void main() {\n"
+    "    v_color = a_color;\n"
+    "    gl_Position = vec4((a_rect.xy + a_corner * a_rect.zw) * u_scale + u_offset, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* gl3_instance_fragment_shader =
+    "#version 330 core\n"
+    "in vec4 v_color;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    frag_color = v_color;\n"
+    "}\n";
+
+static GLuint gl3_compile_shader(GLenum type, const char* source) {
+    GLuint shader = gl.CreateShader(type);
+    gl.ShaderSource(shader, 1, &source, NULL);
+    gl.CompileShader(shader);
+
+    GLint status = GL_FALSE;
+    gl.GetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[192];
+        gl.GetShaderInfoLog(shader, sizeof(log), NULL, log);
+        set_error("Failed to compile shader: %s", log);
+        gl.DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static GLuint gl3_create_program(const char* vertex_source, const char* fragment_source) {
+    GLuint vertex = gl3_compile_shader(GL_VERTEX_SHADER, vertex_source);
+    if (!vertex) {
+        return 0;
+    }
+    GLuint fragment = gl3_compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+    if (!fragment) {
+        gl.DeleteShader(vertex);
+        return 0;
+    }
+
+    GLuint program = gl.CreateProgram();
+    gl.AttachShader(program, vertex);
+    gl.AttachShader(program, fragment);
+    gl.LinkProgram(program);
+    gl.DeleteShader(vertex);
+    gl.DeleteShader(fragment);
+
+    GLint status = GL_FALSE;
+    gl.GetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[192];
+        gl.GetProgramInfoLog(program, sizeof(log), NULL, log);
+        set_error("Failed to link shader program: %s", log);
+        gl.DeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// Unit quad per instance, stretched over the instance rect in the shader
+static int gl3_create_instance_pipeline(BUMI_GLRenderData* data) {
+    static const float corners[8] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+
+    data->instance_program = gl3_create_program(gl3_instance_vertex_shader, gl3_instance_fragment_shader);
+    if (!data->instance_program) {
+        return -1;
+    }
+    data->instance_scale_location = gl.GetUniformLocation(data->instance_program, "u_scale");
+    data->instance_offset_location = gl.GetUniformLocation(data->instance_program, "u_offset");
+
+    gl.GenVertexArrays(1, &data->instance_vao);
+    gl.BindVertexArray(data->instance_vao);
+    gl.GenBuffers(1, &data->corner_vbo);
+    gl.BindBuffer(GL_ARRAY_BUFFER, data->corner_vbo);
+    gl.BufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    gl.EnableVertexAttribArray(0);
+    gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+
+    gl.GenBuffers(1, &data->instance_vbo);
+    gl.EnableVertexAttribArray(1);
+    gl.VertexAttribDivisor(1, 1);
+    gl.VertexAttribDivisor(2, 1);
+    return 0;
+}
+
+// Program, vertex layout and VBO ring; the context must be current
+static int gl3_create_pipeline(BUMI_GLRenderData* data) {
+    if (gl3_create_instance_pipeline(data) != 0) {
+        return -1;
+    }
+    data->program = gl3_create_program(gl3_vertex_shader, gl3_fragment_shader);
+    if (!data->program) {
+        return -1;
+    }
+    gl.UseProgram(data->program);
+    data->scale_location = gl.GetUniformLocation(data->program, "u_scale");
+    data->offset_location = gl.GetUniformLocation(data->program, "u_offset");
+    data->textured_location = gl.GetUniformLocation(data->program, "u_textured");
+    gl.Uniform1i(gl.GetUniformLocation(data->program, "u_texture"), 0);
+
+    gl.GenVertexArrays(1, &data->vao);
+    gl.BindVertexArray(data->vao);
+    gl.GenBuffers(1, &data->vbo);
+    gl.BindBuffer(GL_ARRAY_BUFFER, data->vbo);
+
+    if (gl.has_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr size = (GLsizeiptr) BUMI_GL_VBO_RING * BUMI_GL_VBO_SEGMENT_VERTICES * sizeof(BUMI_GLVertex);
+        gl.BufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+        data->mapped = (BUMI_GLVertex*) gl.MapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+    }
+    if (!data->mapped) {
+        gl.BufferData(GL_ARRAY_BUFFER, BUMI_GL_VBO_SEGMENT_VERTICES * sizeof(BUMI_GLVertex), NULL, GL_STREAM_DRAW);
+    }
+
+    gl.EnableVertexAttribArray(0);
+    gl.EnableVertexAttribArray(1);
+    gl.EnableVertexAttribArray(2);
+    gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(BUMI_GLVertex), (const void*) offsetof(BUMI_GLVertex, x));
+    gl.VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(BUMI_GLVertex), (const void*) offsetof(BUMI_GLVertex, u));
+    gl.VertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BUMI_GLVertex), (const void*) offsetof(BUMI_GLVertex, color));
+    return 0;
+}
+
+static bool gl3_context_failed = false;
+
+static int gl3_error_handler(Display* dpy, XErrorEvent* event) {
+    (void) dpy;
+    (void) event;
+    gl3_context_failed = true;
+    return 0;
+}
+
+static int gl3_create_renderer(BUMI_Renderer* renderer) {
+    BUMI_Window* window = renderer->window;
+    const char* glx_extensions = glXQueryExtensionsString(ctx->dpy, ctx->screen);
+    PFNGLXCREATECONTEXTATTRIBSARBPROC create_context = NULL;
+    if (has_extension(glx_extensions, "GLX_ARB_create_context_profile")) {
+        create_context = (PFNGLXCREATECONTEXTATTRIBSARBPROC) gl_get_proc("glXCreateContextAttribsARB");
+    }
+    if (!create_context) {
+        set_error("GLX_ARB_create_context_profile is not available");
+        return -1;
+    }
+
+    if (!ctx->fbconfig) {
+        set_error("Display has no usable GLX framebuffer config");
+        return -1;
+    }
+
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) BUMI_internal_calloc(1, sizeof(BUMI_GLRenderData));
+    if (!data) {
+        set_error("Failed to allocate renderer data");
+        return -1;
+    }
+
+    // An unsupported version is reported as an X error rather than NULL
+    static const int context_attribs[] = {
+        GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+        GLX_CONTEXT_MINOR_VERSION_ARB, 3,
+        GLX_CONTEXT_PROFILE_MASK_ARB, GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+        None
+    };
+    gl3_context_failed = false;
+    XErrorHandler previous = XSetErrorHandler(gl3_error_handler);
+    data->context = create_context(ctx->dpy, ctx->fbconfig, gl_share_context(true), True, context_attribs);
+    XSync(ctx->dpy, False);
+    XSetErrorHandler(previous);
+    if (!data->context || gl3_context_failed) {
+        if (data->context) {
+            glXDestroyContext(ctx->dpy, data->context);
+        }
+        BUMI_internal_free(data);
+        set_error("Failed to create OpenGL 3.3 core context");
+        return -1;
+    }
+    data->core = true;
+    renderer->renderer_data = data;
+
+    gl_make_current(renderer);
+    gl_load_functions();
+    gl_load_core_functions();
+    if (!gl.has_core) {
+        set_error("OpenGL 3.3 entry points are missing");
+    }
+    if (!gl.has_core || gl3_create_pipeline(data) != 0) {
+        gl_destroy_renderer(renderer);
+        renderer->renderer_data = NULL;
+        return -1;
+    }
+
+    gl_update_viewport(renderer);
+    data->retained = (renderer->flags & BUMI_RENDERER_PARTIAL_PRESENT) && gl.CopySubBufferMESA;
+    data->swap_interval = data->applied_interval = 1;
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glXSwapBuffers(ctx->dpy, (Window)(uintptr_t)window->backend_data);
+    return 0;
+}
+
+static int gl_clear(BUMI_Renderer* renderer) {
+    // Pending fills would be overwritten by the clear, so drop them unsubmitted
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    data->vertex_count = 0;
+    damage_add_clear(&data->damage, renderer);
+
+    gl_make_current(renderer);
+    glClearColor(renderer->draw_color[0], renderer->draw_color[1], renderer->draw_color[2], renderer->draw_color[3]);
+    glClear(GL_COLOR_BUFFER_BIT);
+    return 0;
+}
+
+static int gl_fill_rects(BUMI_Renderer* renderer, const BUMI_Rect* rects, int count) {
+    if (!gl_begin_batch(renderer, 0, count * 6)) {
+        return -1;
+    }
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+
+    uint8_t color[4];
+    draw_color_bytes(renderer, color);
+    for (int i = 0; i < count; i++) {
+        gl_queue_rect(data, color, (float) rects[i].x, (float) rects[i].y, (float) rects[i].w, (float) rects[i].h);
+        damage_add_draw(&data->damage, renderer, &rects[i]);
+    }
+    return 0;
+}
+
+// Core profile: one glDrawArraysInstanced for the whole array
+static void gl3_fill_rects_instanced(BUMI_Renderer* renderer, const BUMI_Rect* rects, const BUMI_Color* colors, int count) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    size_t rect_size = (size_t) count * sizeof(BUMI_Rect);
+    size_t color_size = colors ? (size_t) count * sizeof(BUMI_Color) : 0;
+
+    gl.BindVertexArray(data->instance_vao);
+    gl.BindBuffer(GL_ARRAY_BUFFER, data->instance_vbo);
+    // Respecifying the store orphans the previous draw's instances
+    gl.BufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(rect_size + color_size), NULL, GL_STREAM_DRAW);
+    gl.BufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr) rect_size, rects);
+    gl.VertexAttribPointer(1, 4, GL_INT, GL_FALSE, sizeof(BUMI_Rect), NULL);
+    if (colors) {
+        gl.BufferSubData(GL_ARRAY_BUFFER, (GLintptr) rect_size, (GLsizeiptr) color_size, colors);
+        gl.EnableVertexAttribArray(2);
+        gl.VertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BUMI_Color), (const void*) rect_size);
+    } else {
+        gl.DisableVertexAttribArray(2);
+        gl.VertexAttrib4f(2, renderer->draw_color[0], renderer->draw_color[1], renderer->draw_color[2], renderer->draw_color[3]);
+    }
+
+    gl.UseProgram(data->instance_program);
+    gl.DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    gl.UseProgram(data->program);
+    gl.BindVertexArray(data->vao);
+    gl.BindBuffer(GL_ARRAY_BUFFER, data->vbo);
+}
+
+static int gl_fill_rects_instanced(BUMI_Renderer* renderer, const BUMI_Rect* rects, const BUMI_Color* colors, int count) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    if (data->core) {
+        // Queued draws go first to keep painter's order
+        gl_flush_batch(renderer);
+        gl_make_current(renderer);
+        gl_update_viewport(renderer);
+        gl3_fill_rects_instanced(renderer, rects, colors, count);
+        damage_add_bounds(&data->damage, renderer, rects, count);
+        return 0;
+    }
+
+    // Fixed-function contexts have no instancing; expand to quads on the CPU
+    if (!gl_begin_batch(renderer, 0, count * 6)) {
+        return -1;
+    }
+    uint8_t color[4];
+    draw_color_bytes(renderer, color);
+    for (int i = 0; i < count; i++) {
+        if (colors) {
+            color[0] = colors[i].r;
+            color[1] = colors[i].g;
+            color[2] = colors[i].b;
+            color[3] = colors[i].a;
+        }
+        gl_queue_rect(data, color, (float) rects[i].x, (float) rects[i].y, (float) rects[i].w, (float) rects[i].h);
+    }
+    damage_add_bounds(&data->damage, renderer, rects, count);
+    return 0;
+}
+
+// Copy part of the retained back buffer to the window (GL rows run bottom-up)
+static void gl_copy_sub_buffer(BUMI_Renderer* renderer, const BUMI_Rect* area) {
+    int y = renderer->window->h - (area->y + area->h);
+    gl.CopySubBufferMESA(ctx->dpy, (Window)(uintptr_t)renderer->window->backend_data, area->x, y, area->w, area->h);
+}
+
+// glXSwapIntervalEXT names the drawable, so no context switch is needed
+static void gl_apply_interval(BUMI_Renderer* renderer, int interval) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    if (data->applied_interval != interval && gl.SwapIntervalEXT) {
+        gl.SwapIntervalEXT(ctx->dpy, (Window)(uintptr_t)renderer->window->backend_data, interval);
+        data->applied_interval = interval;
+    }
+}
+
+// Swap or, when retained, copy the touched regions to the window. Neither
+// needs the renderer's context bound: GLX takes the drawable
+static void gl_swap(BUMI_Renderer* renderer) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    if (data->retained) {
+        // Only the touched regions go to the window; the back buffer keeps
+        // the whole frame for the next one to draw on top of
+        for (int i = 0; i < data->damage.count; i++) {
+            gl_copy_sub_buffer(renderer, &data->damage.rects[i]);
+        }
+    } else {
+        glXSwapBuffers(ctx->dpy, (Window)(uintptr_t)renderer->window->backend_data);
+    }
+    data->damage.count = 0;
+}
+
+static void gl_present(BUMI_Renderer* renderer) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    gl_flush_batch(renderer);
+    gl_make_current(renderer);
+    gl_apply_interval(renderer, data->swap_interval);
+    gl_swap(renderer);
+}
+
+static bool gl_dirty(BUMI_Renderer* renderer) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    return data->damage.count > 0 || data->vertex_count > 0;
+}
+
+// Queued batches are submitted first, starting with the current renderer
+// so it costs no switch; each switch flushes the context left behind. The
+// windows are then swapped from whatever is bound, without another
+// glXMakeCurrent. The renderer left current goes last and alone keeps the
+// app's swap interval: with GLX_EXT_swap_control the others swap at once
+// instead of each waiting for its own vertical blank. glXSwapIntervalMESA
+// only reaches the current drawable, so there every swap keeps its interval
+static void gl_present_many(BUMI_Renderer** renderers, int count) {
+    if (gl_current_renderer) {
+        gl_flush_batch(gl_current_renderer);
+    }
+    for (int i = 0; i < count; i++) {
+        gl_flush_batch(renderers[i]);
+    }
+
+    int last = count - 1;
+    for (int i = 0; i < count; i++) {
+        if (renderers[i] == gl_current_renderer) {
+            last = i;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (i != last) {
+            gl_apply_interval(renderers[i], 0);
+            gl_swap(renderers[i]);
+        }
+    }
+    gl_apply_interval(renderers[last], ((BUMI_GLRenderData*) renderers[last]->renderer_data)->swap_interval);
+    gl_swap(renderers[last]);
+}
+
+static int gl_repaint(BUMI_Renderer* renderer, const BUMI_Rect* area) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    if (!data->retained || renderer->target ||
+        data->viewport_w != renderer->window->w || data->viewport_h != renderer->window->h) {
+        return -1;
+    }
+
+    gl_make_current(renderer);
+    gl_copy_sub_buffer(renderer, area);
+    return 0;
+}
+
+// Backend data behind BUMI_Texture::texture_data for the GLX renderer
+typedef struct {
+    GLuint id;
+    GLenum format;                 // GL_RGBA or GL_BGRA
+    GLuint pbos[BUMI_GL_PBO_RING]; // Streaming upload ring, unused for static textures
+    int pbo_index;
+    uint8_t* staging;              // Lock memory when PBOs are unavailable
+    bool locked;
+    BUMI_Rect lock_rect;
+    GLuint fbo;                    // Render target textures only
+} BUMI_GLTextureData;
+
+// Queued draws must sample the texture contents they were issued against.
+// Any renderer in the share group may have it in its batch
+static void gl_flush_texture(BUMI_Texture* texture) {
+    BUMI_GLTextureData* tex = (BUMI_GLTextureData*) texture->texture_data;
+    for (BUMI_Window* window = ctx->windows; window; window = window->next) {
+        for (BUMI_Renderer* renderer = window->renderers; renderer; renderer = renderer->next) {
+            if (renderer->driver != texture->renderer->driver) {
+                continue;
+            }
+            BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+            if (data->batch_texture == tex->id && data->vertex_count > 0) {
+                gl_flush_batch(renderer);
+            }
+        }
+    }
+}
+
+static int gl_create_texture(BUMI_Texture* texture) {
+    BUMI_GLTextureData* tex = (BUMI_GLTextureData*) BUMI_internal_calloc(1, sizeof(BUMI_GLTextureData));
+    if (!tex) {
+        set_error("Failed to allocate texture");
+        return -1;
+    }
+    tex->format = texture->format == BUMI_PIXELFORMAT_RGBA32 ? GL_RGBA : GL_BGRA;
+
+    if (texture->access == BUMI_TEXTUREACCESS_STREAMING && !gl.has_pbo) {
+        tex->staging = (uint8_t*) BUMI_internal_malloc((size_t) texture->w * texture->h * 4);
+        if (!tex->staging) {
+            BUMI_internal_free(tex);
+            set_error("Failed to allocate texture staging memory");
+            return -1;
+        }
+    }
+    texture->texture_data = tex;
+
+    gl_make_current(texture->renderer);
+    glGenTextures(1, &tex->id);
+    glBindTexture(GL_TEXTURE_2D, tex->id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture->w, texture->h, 0, tex->format, GL_UNSIGNED_BYTE, NULL);
+
+    if (texture->access == BUMI_TEXTUREACCESS_STREAMING && gl.has_pbo) {
+        gl.GenBuffers(BUMI_GL_PBO_RING, tex->pbos);
+    }
+
+    if (texture->access == BUMI_TEXTUREACCESS_TARGET) {
+        if (!gl.has_fbo) {
+            glDeleteTextures(1, &tex->id);
+            BUMI_internal_free(tex);
+            texture->texture_data = NULL;
+            set_error("Render targets need framebuffer object support");
+            return -1;
+        }
+
+        gl.GenFramebuffers(1, &tex->fbo);
+        gl.BindFramebuffer(GL_FRAMEBUFFER, tex->fbo);
+        gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex->id, 0);
+        GLenum status = gl.CheckFramebufferStatus(GL_FRAMEBUFFER);
+        BUMI_Texture* current = texture->renderer->target;
+        gl.BindFramebuffer(GL_FRAMEBUFFER, current ? ((BUMI_GLTextureData*) current->texture_data)->fbo : 0);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            gl.DeleteFramebuffers(1, &tex->fbo);
+            glDeleteTextures(1, &tex->id);
+            BUMI_internal_free(tex);
+            texture->texture_data = NULL;
+            set_error("Render target framebuffer is incomplete (0x%x)", status);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void gl_destroy_texture(BUMI_Texture* texture) {
+    BUMI_GLTextureData* tex = (BUMI_GLTextureData*) texture->texture_data;
+
+    gl_flush_texture(texture);
+    gl_make_current(texture->renderer);
+    if (tex->locked && tex->pbos[0]) {
+        gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, tex->pbos[tex->pbo_index]);
+        gl.UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    if (tex->pbos[0]) {
+        gl.DeleteBuffers(BUMI_GL_PBO_RING, tex->pbos);
+    }
+    if (tex->fbo) {
+        gl.DeleteFramebuffers(1, &tex->fbo);
+    }
+    glDeleteTextures(1, &tex->id);
+
+    BUMI_internal_free(tex->staging);
+    BUMI_internal_free(tex);
+}
+
+static int gl_update_texture(BUMI_Texture* texture, const BUMI_Rect* rect, const void* pixels, int pitch) {
+    // Streaming textures take the same asynchronous path as lock/unlock
+    if (texture->access == BUMI_TEXTUREACCESS_STREAMING) {
+        void* locked;
+        int locked_pitch;
+        if (BUMI_TextureLock(texture, rect, &locked, &locked_pitch) != 0) {
+            return -1;
+        }
+        for (int row = 0; row < rect->h; row++) {
+            memcpy((uint8_t*) locked + (size_t) row * locked_pitch,
+                   (const uint8_t*) pixels + (size_t) row * pitch, (size_t) rect->w * 4);
+        }
+        BUMI_TextureUnlock(texture);
+        return 0;
+    }
+
+    BUMI_GLTextureData* tex = (BUMI_GLTextureData*) texture->texture_data;
+    gl_flush_texture(texture);
+    gl_make_current(texture->renderer);
+    glBindTexture(GL_TEXTURE_2D, tex->id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect->x, rect->y, rect->w, rect->h, tex->format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    return 0;
+}
+
+static int gl_lock_texture(BUMI_Texture* texture, const BUMI_Rect* rect, void** pixels, int* pitch) {
+    BUMI_GLTextureData* tex = (BUMI_GLTextureData*) texture->texture_data;
+    if (tex->locked) {
+        set_error("Texture is already locked");
+        return -1;
+    }
+
+    tex->lock_rect = *rect;
+    *pitch = rect->w * 4;
+    if (!tex->pbos[0]) {
+        *pixels = tex->staging;
+        tex->locked = true;
+        return 0;
+    }
+
+    // Orphan the next buffer in the ring so mapping never waits on an upload
+    // the GPU is still reading from
+    gl_make_current(texture->renderer);
+    GLsizeiptr size = (GLsizeiptr) *pitch * rect->h;
+    gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, tex->pbos[tex->pbo_index]);
+    gl.BufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    *pixels = gl.MapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (!*pixels) {
+        set_error("Failed to map texture upload buffer");
+        return -1;
+    }
+
+    tex->locked = true;
+    return 0;
+}
+
+static void gl_unlock_texture(BUMI_Texture* texture) {
+    BUMI_GLTextureData* tex = (BUMI_GLTextureData*) texture->texture_data;
+    if (!tex->locked) {
+        return;
+    }
+    tex->locked = false;
+
+    const BUMI_Rect* area = &tex->lock_rect;
+    gl_flush_texture(texture);
+    gl_make_current(texture->renderer);
+    glBindTexture(GL_TEXTURE_2D, tex->id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (!tex->pbos[0]) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, area->x, area->y, area->w, area->h, tex->format, GL_UNSIGNED_BYTE, tex->staging);
+        return;
+    }
+
+    // The copy out of the buffer runs asynchronously on the GPU
+    gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, tex->pbos[tex->pbo_index]);
+    gl.UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, area->x, area->y, area->w, area->h, tex->format, GL_UNSIGNED_BYTE, NULL);
+    gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    tex->pbo_index = (tex->pbo_index + 1) % BUMI_GL_PBO_RING;
+}
+
+static int gl_copy(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Rect* src, const BUMI_Rect* dst) {
+    BUMI_GLTextureData* tex = (BUMI_GLTextureData*) texture->texture_data;
+    if (!gl_begin_batch(renderer, tex->id, 6)) {
+        return -1;
+    }
+
+    static const uint8_t white[4] = {255, 255, 255, 255};
+    float u0 = (float) src->x / texture->w;
+    float v0 = (float) src->y / texture->h;
+    float u1 = (float)(src->x + src->w) / texture->w;
+    float v1 = (float)(src->y + src->h) / texture->h;
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    gl_queue_quad(data, white, (float) dst->x, (float) dst->y, (float) dst->w, (float) dst->h, u0, v0, u1, v1);
+    damage_add_draw(&data->damage, renderer, dst);
+    return 0;
+}
+
+static int gl_copy_batch(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Rect* srcs, const BUMI_Rect* dsts,
+                         int count, const uint8_t color[4]) {
+    BUMI_GLTextureData* tex = (BUMI_GLTextureData*) texture->texture_data;
+    if (!gl_begin_batch(renderer, tex->id, count * 6)) {
+        return -1;
+    }
+
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    float sx = 1.0f / texture->w;
+    float sy = 1.0f / texture->h;
+    for (int i = 0; i < count; i++) {
+        const BUMI_Rect* src = &srcs[i];
+        const BUMI_Rect* dst = &dsts[i];
+        gl_queue_quad(data, color, (float) dst->x, (float) dst->y, (float) dst->w, (float) dst->h,
+                      src->x * sx, src->y * sy, (src->x + src->w) * sx, (src->y + src->h) * sy);
+    }
+    damage_add_bounds(&data->damage, renderer, dsts, count);
+    return 0;
+}
+
+static int gl_geometry(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Vertex* vertices, int num_vertices,
+                       const int* indices, int num_indices) {
+    GLuint id = texture ? ((BUMI_GLTextureData*) texture->texture_data)->id : 0;
+    int count = indices ? num_indices : num_vertices;
+    if (!gl_begin_batch(renderer, id, count)) {
+        return -1;
+    }
+
+    // Indices are resolved here so the triangles share the batch's one draw
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    BUMI_GLVertex* out = &data->vertices[data->vertex_count];
+    for (int i = 0; i < count; i++) {
+        const BUMI_Vertex* v = &vertices[indices ? indices[i] : i];
+        out[i].x = v->x;
+        out[i].y = v->y;
+        out[i].u = v->u;
+        out[i].v = v->v;
+        out[i].color[0] = v->color.r;
+        out[i].color[1] = v->color.g;
+        out[i].color[2] = v->color.b;
+        out[i].color[3] = v->color.a;
+    }
+    data->vertex_count += count;
+
+    BUMI_Rect bounds = vertex_bounds(vertices, num_vertices);
+    damage_add_draw(&data->damage, renderer, &bounds);
+    return 0;
+}
+
+static int gl_set_swap_interval(BUMI_Renderer* renderer, int interval) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    gl_make_current(renderer);
+    if (gl.SwapIntervalEXT) {
+        gl.SwapIntervalEXT(ctx->dpy, (Window)(uintptr_t)renderer->window->backend_data, interval);
+        data->swap_interval = data->applied_interval = interval;
+        return 0;
+    }
+    if (gl.SwapIntervalMESA && interval >= 0) {
+        if (gl.SwapIntervalMESA((unsigned int) interval) != 0) {
+            set_error("glXSwapIntervalMESA failed");
+            return -1;
+        }
+        data->swap_interval = data->applied_interval = interval;
+        return 0;
+    }
+    set_error("GLX swap control is not available");
+    return -1;
+}
+
+// Timing of the most recent swap the display has completed
+static int gl_get_present_timing(BUMI_Renderer* renderer, BUMI_PresentTiming* timing) {
+    if (!gl.GetSyncValuesOML || !gl.WaitForSbcOML) {
+        set_error("GLX_OML_sync_control is not available");
+        return -1;
+    }
+
+    Window window = (Window)(uintptr_t)renderer->window->backend_data;
+    int64_t ust, msc, sbc;
+    gl_make_current(renderer);
+    if (!gl.GetSyncValuesOML(ctx->dpy, window, &ust, &msc, &sbc) || sbc <= 0) {
+        set_error("No completed swap to report");
+        return -1;
+    }
+
+    // sbc has already been reached, so this returns at once with its timestamp
+    if (!gl.WaitForSbcOML(ctx->dpy, window, sbc, &ust, &msc, &sbc)) {
+        set_error("Failed to query swap timestamp");
+        return -1;
+    }
+    timing->ust = ust;
+    timing->msc = msc;
+    timing->sbc = sbc;
+    return 0;
+}
+
+static int gl_set_target(BUMI_Renderer* renderer, BUMI_Texture* texture) {
+    // Pending draws belong to the old output
+    gl_flush_batch(renderer);
+    gl_make_current(renderer);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, texture ? ((BUMI_GLTextureData*) texture->texture_data)->fbo : 0);
+    return 0;
+}
+
+static int gl_read_pixels(BUMI_Renderer* renderer, const BUMI_Rect* rect, uint32_t format, void* pixels, int pitch) {
+    gl_flush_batch(renderer);
+    gl_make_current(renderer);
+    gl_update_viewport(renderer);
+
+    // The window's rows run bottom-up; targets are kept top-down
+    int y = rect->y;
+    if (!renderer->target) {
+        y = renderer->window->h - (rect->y + rect->h);
+        glReadBuffer(GL_BACK);
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH, pitch / 4);
+    glReadPixels(rect->x, y, rect->w, rect->h, format == BUMI_PIXELFORMAT_RGBA32 ? GL_RGBA : GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+
+    if (!renderer->target) {
+        uint8_t* top = (uint8_t*) pixels;
+        uint8_t* bottom = top + (size_t)(rect->h - 1) * pitch;
+        size_t row = (size_t) rect->w * 4;
+        for (; top < bottom; top += pitch, bottom -= pitch) {
+            for (size_t i = 0; i < row; i++) {
+                uint8_t t = top[i];
+                top[i] = bottom[i];
+                bottom[i] = t;
+            }
+        }
+    }
+    return 0;
+}
+
+// Hand finished readbacks to the writer, oldest first. Without `wait`,
+// stops at the first one the GPU hasn't finished
+static void gl_capture_drain(BUMI_Renderer* renderer, bool wait) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    BUMI_Capture* capture = renderer->capture;
+    while (data->capture_pending > 0) {
+        int slot = data->capture_head;
+        GLenum status = gl.ClientWaitSync(data->capture_fences[slot], wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                          wait ? UINT64_MAX : 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            break;
+        }
+        gl.DeleteSync(data->capture_fences[slot]);
+        data->capture_fences[slot] = NULL;
+
+        BUMI_CaptureFrame* frame = capture_acquire(capture);
+        if (frame) {
+            gl.BindBuffer(GL_PIXEL_PACK_BUFFER, data->capture_pbos[slot]);
+            const uint8_t* pixels = (const uint8_t*) gl.MapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+            if (pixels) {
+                int w = data->capture_sizes[slot][0];
+                int h = data->capture_sizes[slot][1];
+                capture_fill(capture, frame, pixels, w * 4, w, h, true);
+                gl.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                capture_submit(capture);
+            } else {
+                capture_drop(capture);
+            }
+            gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        data->capture_head = (data->capture_head + 1) % BUMI_GL_CAPTURE_RING;
+        data->capture_pending--;
+    }
+}
+
+// Queue an asynchronous readback of the back buffer into the next PBO;
+// it is copied out on a later present, once its fence has signaled
+static void gl_capture_frame(BUMI_Renderer* renderer) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    BUMI_Capture* capture = renderer->capture;
+    gl_flush_batch(renderer);
+    gl_make_current(renderer);
+
+    // The top-left of the window, as much of it as the capture holds
+    int w = renderer->window->w < capture->w ? renderer->window->w : capture->w;
+    int h = renderer->window->h < capture->h ? renderer->window->h : capture->h;
+    glReadBuffer(GL_BACK);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+
+    if (!gl.has_pbo || !gl.has_sync) {
+        BUMI_CaptureFrame* frame = capture_acquire(capture);
+        if (!frame) {
+            return;
+        }
+        if (!data->capture_staging) {
+            data->capture_staging = (uint8_t*) BUMI_internal_malloc((size_t) capture->w * capture->h * 4);
+            if (!data->capture_staging) {
+                capture_drop(capture);
+                return;
+            }
+        }
+        glReadPixels(0, renderer->window->h - h, w, h, GL_BGRA, GL_UNSIGNED_BYTE, data->capture_staging);
+        capture_fill(capture, frame, data->capture_staging, w * 4, w, h, true);
+        capture_submit(capture);
+        return;
+    }
+
+    gl_capture_drain(renderer, false);
+    if (data->capture_pending == BUMI_GL_CAPTURE_RING) {
+        capture_drop(capture);
+        return;
+    }
+    if (!data->capture_pbos[0]) {
+        gl.GenBuffers(BUMI_GL_CAPTURE_RING, data->capture_pbos);
+        for (int i = 0; i < BUMI_GL_CAPTURE_RING; i++) {
+            gl.BindBuffer(GL_PIXEL_PACK_BUFFER, data->capture_pbos[i]);
+            gl.BufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr) capture->w * capture->h * 4, NULL, GL_STREAM_READ);
+        }
+    }
+
+    int slot = (data->capture_head + data->capture_pending) % BUMI_GL_CAPTURE_RING;
+    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, data->capture_pbos[slot]);
+    glReadPixels(0, renderer->window->h - h, w, h, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    data->capture_fences[slot] = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    data->capture_sizes[slot][0] = w;
+    data->capture_sizes[slot][1] = h;
+    data->capture_pending++;
+}
+
+static void gl_end_capture(BUMI_Renderer* renderer) {
+    BUMI_GLRenderData* data = (BUMI_GLRenderData*) renderer->renderer_data;
+    gl_make_current(renderer);
+    gl_capture_drain(renderer, true);
+    if (data->capture_pbos[0]) {
+        gl.DeleteBuffers(BUMI_GL_CAPTURE_RING, data->capture_pbos);
+        memset(data->capture_pbos, 0, sizeof(data->capture_pbos));
+    }
+    BUMI_internal_free(data->capture_staging);
+    data->capture_staging = NULL;
+}
+
+// Shares texture, present and readback paths with the fixed-function driver;
+// only context creation and batch submission differ
+static const BUMI_RenderDriver gl3_driver = {
+    "opengl_core",
+    BUMI_RENDERER_ACCELERATED,
+    gl3_create_renderer,
+    gl_destroy_renderer,
+    gl_clear,
+    gl_fill_rects,
+    gl_fill_rects_instanced,
+    gl_copy,
+    gl_copy_batch,
+    gl_geometry,
+    gl_present,
+    gl_dirty,
+    gl_present_many,
+    gl_create_texture,
+    gl_destroy_texture,
+    gl_update_texture,
+    gl_lock_texture,
+    gl_unlock_texture,
+    gl_set_swap_interval,
+    gl_get_present_timing,
+    gl_repaint,
+    gl_set_target,
+    gl_read_pixels,
+    gl_capture_frame,
+    gl_end_capture
+};
+
+static const BUMI_RenderDriver gl_driver = {
+    "opengl",
+    BUMI_RENDERER_ACCELERATED,
+    gl_create_renderer,
+    gl_destroy_renderer,
+    gl_clear,
+    gl_fill_rects,
+    gl_fill_rects_instanced,
+    gl_copy,
+    gl_copy_batch,
+    gl_geometry,
+    gl_present,
+    gl_dirty,
+    gl_present_many,
+    gl_create_texture,
+    gl_destroy_texture,
+    gl_update_texture,
+    gl_lock_texture,
+    gl_unlock_texture,
+    gl_set_swap_interval,
+    gl_get_present_timing,
+    gl_repaint,
+    gl_set_target,
+    gl_read_pixels,
+    gl_capture_frame,
+    gl_end_capture
+};
+
+// === SOFTWARE RENDERER ===
+
+// Backend data behind BUMI_Renderer::renderer_data for the software renderer.
+// Draws are queued and rasterized tile-parallel on present, straight into an
+// XImage that lives in shared memory when MIT-SHM is available.
+typedef struct {
+    XImage* image;
+    XShmSegmentInfo shm;
+    bool use_shm;
+    bool put_pending;          // Server may still be reading the shared image
+    GC gc;
+    BUMI_SWSurface surface;    // Aliases image->data
+    BUMI_SWPool* pool;
+    BUMI_SWCommand* commands;
+    int command_count;
+    int command_capacity;
+    BUMI_SWVertex* vertices;   // Corners of queued triangles
+    int vertex_count;
+    int vertex_capacity;
+    BUMI_Damage damage;
+} BUMI_SWRenderData;
+
+// Backend data behind BUMI_Texture::texture_data for the software renderer.
+// Lock hands out the pixels directly, so there is nothing to upload
+typedef struct {
+    BUMI_SWSurface surface;
+} BUMI_SWTextureData;
+
+static bool sw_shm_failed = false;
+
+static int sw_shm_error_handler(Display* dpy, XErrorEvent* error) {
+    (void) dpy;
+    (void) error;
+    sw_shm_failed = true;
+    return 0;
+}
+
+static void sw_destroy_image(BUMI_SWRenderData* data) {
+    if (!data->image) return;
+
+    if (data->use_shm) {
+        XShmDetach(ctx->dpy, &data->shm);
+        XSync(ctx->dpy, False);
+        data->image->data = NULL;
+        XDestroyImage(data->image);
+        shmdt(data->shm.shmaddr);
+    } else {
+        // XDestroyImage would hand our pixels to free()
+        BUMI_internal_free(data->image->data);
+        data->image->data = NULL;
+        XDestroyImage(data->image);
+    }
+    data->image = NULL;
+    data->put_pending = false;
+    memset(&data->surface, 0, sizeof(data->surface));
+}
+
+static int sw_create_shm_image(BUMI_SWRenderData* data, Visual* visual, int depth, int w, int h) {
+    data->image = XShmCreateImage(ctx->dpy, visual, depth, ZPixmap, NULL, &data->shm, w, h);
+    if (!data->image) {
+        return 0;
+    }
+
+    data->shm.shmid = shmget(IPC_PRIVATE, (size_t) data->image->bytes_per_line * h, IPC_CREAT | 0600);
+    if (data->shm.shmid < 0) {
+        XDestroyImage(data->image);
+        data->image = NULL;
+        return 0;
+    }
+    data->shm.shmaddr = data->image->data = (char*) shmat(data->shm.shmid, NULL, 0);
+    data->shm.readOnly = False;
+    if (data->shm.shmaddr == (char*) -1) {
+        shmctl(data->shm.shmid, IPC_RMID, NULL);
+        data->image->data = NULL;
+        XDestroyImage(data->image);
+        data->image = NULL;
+        return 0;
+    }
+
+    // Attaching fails with an X error on remote displays; trap it and fall back
+    sw_shm_failed = false;
+    XErrorHandler previous = XSetErrorHandler(sw_shm_error_handler);
+    XShmAttach(ctx->dpy, &data->shm);
+    XSync(ctx->dpy, False);
+    XSetErrorHandler(previous);
+    shmctl(data->shm.shmid, IPC_RMID, NULL); // Freed once both sides detach
+
+    if (sw_shm_failed) {
+        shmdt(data->shm.shmaddr);
+        data->image->data = NULL;
+        XDestroyImage(data->image);
+        data->image = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+// (Re)create the framebuffer image whenever the window size changes
+static int sw_update_image(BUMI_Renderer* renderer) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    int w = renderer->window->w > 0 ? renderer->window->w : 1;
+    int h = renderer->window->h > 0 ? renderer->window->h : 1;
+    if (data->image && data->surface.w == w && data->surface.h == h) {
+        return 0;
+    }
+
+    sw_destroy_image(data);
+
+    if (!data->use_shm || !sw_create_shm_image(data, ctx->visual, ctx->depth, w, h)) {
+        data->use_shm = false;
+        data->image = XCreateImage(ctx->dpy, ctx->visual, ctx->depth, ZPixmap, 0, NULL, w, h, 32, 0);
+        if (data->image) {
+            data->image->data = (char*) BUMI_internal_malloc((size_t) data->image->bytes_per_line * h);
+            if (!data->image->data) {
+                XDestroyImage(data->image);
+                data->image = NULL;
+            }
+        }
+    }
+    if (!data->image) {
+        set_error("Failed to create software framebuffer");
+        return -1;
+    }
+    if (data->image->bits_per_pixel != 32) {
+        sw_destroy_image(data);
+        set_error("Software renderer requires a 32 bits per pixel visual");
+        return -1;
+    }
+
+    data->surface.pixels = (uint32_t*) data->image->data;
+    data->surface.w = w;
+    data->surface.h = h;
+    data->surface.pitch = data->image->bytes_per_line / 4;
+    damage_add_all(&data->damage, w, h);
+    return 0;
+}
+
+static BUMI_SWCommand* sw_push_command(BUMI_Renderer* renderer, int type) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    if (data->command_count == data->command_capacity) {
+        int capacity = data->command_capacity ? data->command_capacity * 2 : 1024;
+        BUMI_SWCommand* commands =
+            (BUMI_SWCommand*) BUMI_internal_realloc(data->commands, capacity * sizeof(BUMI_SWCommand));
+        if (!commands) {
+            set_error("Failed to grow software command queue");
+            return NULL;
+        }
+        data->commands = commands;
+        data->command_capacity = capacity;
+    }
+
+    BUMI_SWCommand* cmd = &data->commands[data->command_count++];
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->type = type;
+    return cmd;
+}
+
+// Channel order of the current output; the window is always BGRA
+static uint32_t sw_output_format(const BUMI_Renderer* renderer) {
+    return renderer->target ? renderer->target->format : BUMI_PIXELFORMAT_BGRA32;
+}
+
+static uint32_t sw_pack_color(const BUMI_Renderer* renderer, const BUMI_Color* c) {
+    if (sw_output_format(renderer) == BUMI_PIXELFORMAT_RGBA32) {
+        return ((uint32_t) c->a << 24) | ((uint32_t) c->b << 16) | ((uint32_t) c->g << 8) | c->r;
+    }
+    return ((uint32_t) c->a << 24) | ((uint32_t) c->r << 16) | ((uint32_t) c->g << 8) | c->b;
+}
+
+static uint32_t sw_draw_color(const BUMI_Renderer* renderer) {
+    uint8_t c[4];
+    draw_color_bytes(renderer, c);
+    BUMI_Color color = {c[0], c[1], c[2], c[3]};
+    return sw_pack_color(renderer, &color);
+}
+
+// Rasterize everything queued so far into the current output
+static int sw_flush(BUMI_Renderer* renderer) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    if (renderer->target) {
+        BUMI_SWTextureData* tex = (BUMI_SWTextureData*) renderer->target->texture_data;
+        bumi_sw_execute(data->pool, &tex->surface, data->commands, data->command_count, data->vertices);
+        data->command_count = 0;
+        data->vertex_count = 0;
+        return 0;
+    }
+    if (sw_update_image(renderer) != 0) {
+        data->command_count = 0;
+        data->vertex_count = 0;
+        return -1;
+    }
+    if (data->command_count == 0) {
+        return 0;
+    }
+
+    // The previous XShmPutImage must be done reading before pixels change
+    if (data->put_pending) {
+        XSync(ctx->dpy, False);
+        data->put_pending = false;
+    }
+    bumi_sw_execute(data->pool, &data->surface, data->commands, data->command_count, data->vertices);
+    data->command_count = 0;
+    data->vertex_count = 0;
+    return 0;
+}
+
+static int sw_create_renderer(BUMI_Renderer* renderer) {
+    Visual* visual = ctx->visual;
+    if (visual->red_mask != 0xFF0000 || visual->green_mask != 0xFF00 || visual->blue_mask != 0xFF) {
+        set_error("Software renderer requires an XRGB8888 visual");
+        return -1;
+    }
+
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) BUMI_internal_calloc(1, sizeof(BUMI_SWRenderData));
+    if (!data) {
+        set_error("Failed to allocate renderer data");
+        return -1;
+    }
+
+    data->pool = bumi_sw_pool_create(0);
+    if (!data->pool) {
+        BUMI_internal_free(data);
+        set_error("Failed to start software renderer threads");
+        return -1;
+    }
+    data->use_shm = XShmQueryExtension(ctx->dpy);
+    data->gc = XCreateGC(ctx->dpy, (Window)(uintptr_t)renderer->window->backend_data, 0, NULL);
+    renderer->renderer_data = data;
+
+    if (sw_update_image(renderer) != 0) {
+        XFreeGC(ctx->dpy, data->gc);
+        bumi_sw_pool_destroy(data->pool);
+        BUMI_internal_free(data);
+        renderer->renderer_data = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void sw_destroy_renderer(BUMI_Renderer* renderer) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    sw_destroy_image(data);
+    XFreeGC(ctx->dpy, data->gc);
+    bumi_sw_pool_destroy(data->pool);
+    BUMI_internal_free(data->commands);
+    BUMI_internal_free(data->vertices);
+    BUMI_internal_free(data);
+}
+
+static int sw_clear(BUMI_Renderer* renderer) {
+    // Pending draws would be overwritten by the clear, so drop them
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    data->command_count = 0;
+    data->vertex_count = 0;
+    damage_add_clear(&data->damage, renderer);
+
+    BUMI_SWCommand* cmd = sw_push_command(renderer, BUMI_SW_CMD_CLEAR);
+    if (!cmd) {
+        return -1;
+    }
+    cmd->color = sw_draw_color(renderer);
+    return 0;
+}
+
+static int sw_fill_rects(BUMI_Renderer* renderer, const BUMI_Rect* rects, int count) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    uint32_t color = sw_draw_color(renderer);
+    for (int i = 0; i < count; i++) {
+        if (rects[i].w <= 0 || rects[i].h <= 0) {
+            continue;
+        }
+        BUMI_SWCommand* cmd = sw_push_command(renderer, BUMI_SW_CMD_FILL);
+        if (!cmd) {
+            return -1;
+        }
+        cmd->color = color;
+        cmd->dst = rects[i];
+        damage_add_draw(&data->damage, renderer, &rects[i]);
+    }
+    return 0;
+}
+
+static int sw_fill_rects_instanced(BUMI_Renderer* renderer, const BUMI_Rect* rects, const BUMI_Color* colors, int count) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    uint32_t color = sw_draw_color(renderer);
+    for (int i = 0; i < count; i++) {
+        if (rects[i].w <= 0 || rects[i].h <= 0) {
+            continue;
+        }
+        BUMI_SWCommand* cmd = sw_push_command(renderer, BUMI_SW_CMD_FILL);
+        if (!cmd) {
+            return -1;
+        }
+        cmd->color = colors ? sw_pack_color(renderer, &colors[i]) : color;
+        cmd->dst = rects[i];
+    }
+    damage_add_bounds(&data->damage, renderer, rects, count);
+    return 0;
+}
+
+static int sw_copy(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Rect* src, const BUMI_Rect* dst) {
+    if (dst->w <= 0 || dst->h <= 0) {
+        return 0;
+    }
+
+    BUMI_SWCommand* cmd = sw_push_command(renderer, BUMI_SW_CMD_COPY);
+    if (!cmd) {
+        return -1;
+    }
+    cmd->dst = *dst;
+    cmd->src = *src;
+    cmd->texture = &((BUMI_SWTextureData*) texture->texture_data)->surface;
+    cmd->swap_rb = texture->format != sw_output_format(renderer);
+    cmd->color = 0xFFFFFFFFu;
+    damage_add_draw(&((BUMI_SWRenderData*) renderer->renderer_data)->damage, renderer, dst);
+    return 0;
+}
+
+static int sw_copy_batch(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Rect* srcs, const BUMI_Rect* dsts,
+                         int count, const uint8_t color[4]) {
+    const BUMI_SWSurface* surface = &((BUMI_SWTextureData*) texture->texture_data)->surface;
+    bool swap = texture->format != sw_output_format(renderer);
+    BUMI_Color tint = {color[0], color[1], color[2], color[3]};
+    uint32_t modulate = sw_pack_color(renderer, &tint);
+    for (int i = 0; i < count; i++) {
+        if (dsts[i].w <= 0 || dsts[i].h <= 0) {
+            continue;
+        }
+        BUMI_SWCommand* cmd = sw_push_command(renderer, BUMI_SW_CMD_COPY);
+        if (!cmd) {
+            return -1;
+        }
+        cmd->dst = dsts[i];
+        cmd->src = srcs[i];
+        cmd->texture = surface;
+        cmd->swap_rb = swap;
+        cmd->color = modulate;
+    }
+    damage_add_bounds(&((BUMI_SWRenderData*) renderer->renderer_data)->damage, renderer, dsts, count);
+    return 0;
+}
+
+static int sw_geometry(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Vertex* vertices, int num_vertices,
+                       const int* indices, int num_indices) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    int count = indices ? num_indices : num_vertices;
+    if (data->vertex_count + count > data->vertex_capacity) {
+        int capacity = data->vertex_capacity ? data->vertex_capacity : 1024;
+        while (capacity < data->vertex_count + count) {
+            capacity *= 2;
+        }
+        BUMI_SWVertex* grown = (BUMI_SWVertex*) BUMI_internal_realloc(data->vertices, capacity * sizeof(BUMI_SWVertex));
+        if (!grown) {
+            set_error("Failed to grow software vertex queue");
+            return -1;
+        }
+        data->vertices = grown;
+        data->vertex_capacity = capacity;
+    }
+
+    const BUMI_SWSurface* surface = texture ? &((BUMI_SWTextureData*) texture->texture_data)->surface : NULL;
+    bool swap = texture && texture->format != sw_output_format(renderer);
+    for (int i = 0; i < count; i += 3) {
+        BUMI_SWVertex* out = &data->vertices[data->vertex_count];
+        for (int k = 0; k < 3; k++) {
+            const BUMI_Vertex* v = &vertices[indices ? indices[i + k] : i + k];
+            out[k].x = v->x;
+            out[k].y = v->y;
+            out[k].u = v->u;
+            out[k].v = v->v;
+            out[k].color = sw_pack_color(renderer, &v->color);
+        }
+        float area = (out[1].x - out[0].x) * (out[2].y - out[0].y) - (out[1].y - out[0].y) * (out[2].x - out[0].x);
+        if (area == 0) {
+            continue;
+        }
+
+        BUMI_SWCommand* cmd = sw_push_command(renderer, BUMI_SW_CMD_TRIANGLE);
+        if (!cmd) {
+            return -1;
+        }
+        float x0 = fminf(out[0].x, fminf(out[1].x, out[2].x));
+        float y0 = fminf(out[0].y, fminf(out[1].y, out[2].y));
+        cmd->dst.x = (int) floorf(x0);
+        cmd->dst.y = (int) floorf(y0);
+        cmd->dst.w = (int) ceilf(fmaxf(out[0].x, fmaxf(out[1].x, out[2].x))) - cmd->dst.x;
+        cmd->dst.h = (int) ceilf(fmaxf(out[0].y, fmaxf(out[1].y, out[2].y))) - cmd->dst.y;
+        cmd->texture = surface;
+        cmd->swap_rb = swap;
+        cmd->first_vertex = data->vertex_count;
+        data->vertex_count += 3;
+    }
+
+    BUMI_Rect bounds = vertex_bounds(vertices, num_vertices);
+    damage_add_draw(&data->damage, renderer, &bounds);
+    return 0;
+}
+
+// Send part of the framebuffer to the window
+static void sw_put(BUMI_Renderer* renderer, const BUMI_Rect* area) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    Window window = (Window)(uintptr_t)renderer->window->backend_data;
+    if (data->use_shm) {
+        // The server reads the pixels straight out of shared memory
+        XShmPutImage(ctx->dpy, window, data->gc, data->image, area->x, area->y, area->x, area->y, area->w, area->h, False);
+        data->put_pending = true;
+    } else {
+        XPutImage(ctx->dpy, window, data->gc, data->image, area->x, area->y, area->x, area->y, area->w, area->h);
+    }
+}
+
+// The framebuffer persists between frames, so only touched regions move
+static void sw_put_damage(BUMI_Renderer* renderer) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    if (sw_flush(renderer) != 0) {
+        return;
+    }
+
+    for (int i = 0; i < data->damage.count; i++) {
+        BUMI_Rect area;
+        BUMI_Rect bounds = {0, 0, data->surface.w, data->surface.h};
+        if (rect_intersect(&data->damage.rects[i], &bounds, &area)) {
+            sw_put(renderer, &area);
+        }
+    }
+    data->damage.count = 0;
+}
+
+static void sw_present(BUMI_Renderer* renderer) {
+    sw_put_damage(renderer);
+    XFlush(ctx->dpy);
+}
+
+static bool sw_dirty(BUMI_Renderer* renderer) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    return data->damage.count > 0 || data->command_count > 0;
+}
+
+// One round trip covers every window still waiting on its last put, and
+// one flush sends all the new ones
+static void sw_present_many(BUMI_Renderer** renderers, int count) {
+    bool put_pending = false;
+    for (int i = 0; i < count; i++) {
+        put_pending |= ((BUMI_SWRenderData*) renderers[i]->renderer_data)->put_pending;
+    }
+    if (put_pending) {
+        XSync(ctx->dpy, False);
+        for (int i = 0; i < count; i++) {
+            ((BUMI_SWRenderData*) renderers[i]->renderer_data)->put_pending = false;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        sw_put_damage(renderers[i]);
+    }
+    XFlush(ctx->dpy);
+}
+
+static int sw_repaint(BUMI_Renderer* renderer, const BUMI_Rect* area) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    BUMI_Rect bounds = {0, 0, data->surface.w, data->surface.h};
+    BUMI_Rect clipped;
+    if (!data->image) {
+        return -1;
+    }
+    if (rect_intersect(area, &bounds, &clipped)) {
+        sw_put(renderer, &clipped);
+        XFlush(ctx->dpy);
+    }
+    return 0;
+}
+
+static int sw_create_texture(BUMI_Texture* texture) {
+    BUMI_SWTextureData* tex = (BUMI_SWTextureData*) BUMI_internal_calloc(1, sizeof(BUMI_SWTextureData));
+    if (!tex) {
+        set_error("Failed to allocate texture");
+        return -1;
+    }
+
+    tex->surface.pixels = (uint32_t*) BUMI_internal_calloc((size_t) texture->w * texture->h, sizeof(uint32_t));
+    if (!tex->surface.pixels) {
+        BUMI_internal_free(tex);
+        set_error("Failed to allocate texture pixels");
+        return -1;
+    }
+    tex->surface.w = texture->w;
+    tex->surface.h = texture->h;
+    tex->surface.pitch = texture->w;
+    texture->texture_data = tex;
+    return 0;
+}
+
+// Queued copies read the texture when they are rasterized, so every
+// renderer that may have one queued must run it before the pixels change
+static void sw_flush_texture(BUMI_Texture* texture) {
+    for (BUMI_Window* window = ctx->windows; window; window = window->next) {
+        for (BUMI_Renderer* renderer = window->renderers; renderer; renderer = renderer->next) {
+            if (renderer->driver == texture->renderer->driver) {
+                sw_flush(renderer);
+            }
+        }
+    }
+}
+
+static void sw_destroy_texture(BUMI_Texture* texture) {
+    BUMI_SWTextureData* tex = (BUMI_SWTextureData*) texture->texture_data;
+
+    // Queued copies in any window still point at the pixels
+    sw_flush_texture(texture);
+    BUMI_internal_free(tex->surface.pixels);
+    BUMI_internal_free(tex);
+}
+
+static int sw_update_texture(BUMI_Texture* texture, const BUMI_Rect* rect, const void* pixels, int pitch) {
+    BUMI_SWTextureData* tex = (BUMI_SWTextureData*) texture->texture_data;
+
+    sw_flush_texture(texture);
+    for (int row = 0; row < rect->h; row++) {
+        memcpy(tex->surface.pixels + (size_t)(rect->y + row) * tex->surface.pitch + rect->x,
+               (const uint8_t*) pixels + (size_t) row * pitch, (size_t) rect->w * 4);
+    }
+    return 0;
+}
+
+static int sw_lock_texture(BUMI_Texture* texture, const BUMI_Rect* rect, void** pixels, int* pitch) {
+    BUMI_SWTextureData* tex = (BUMI_SWTextureData*) texture->texture_data;
+
+    sw_flush_texture(texture);
+    *pixels = tex->surface.pixels + (size_t) rect->y * tex->surface.pitch + rect->x;
+    *pitch = tex->surface.pitch * 4;
+    return 0;
+}
+
+static void sw_unlock_texture(BUMI_Texture* texture) {
+    (void) texture;
+}
+
+static int sw_set_swap_interval(BUMI_Renderer* renderer, int interval) {
+    (void) renderer;
+    if (interval != 0) {
+        set_error("Software renderer cannot sync to vertical blank; pace frames with BUMI_FramePacer");
+        return -1;
+    }
+    return 0;
+}
+
+static int sw_get_present_timing(BUMI_Renderer* renderer, BUMI_PresentTiming* timing) {
+    (void) renderer;
+    (void) timing;
+    set_error("Software renderer has no present timestamps");
+    return -1;
+}
+
+static int sw_set_target(BUMI_Renderer* renderer, BUMI_Texture* texture) {
+    (void) texture;
+    // Pending draws belong to the old output
+    return sw_flush(renderer);
+}
+
+static int sw_read_pixels(BUMI_Renderer* renderer, const BUMI_Rect* rect, uint32_t format, void* pixels, int pitch) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    if (sw_flush(renderer) != 0) {
+        return -1;
+    }
+
+    const BUMI_SWSurface* surface = renderer->target ? &((BUMI_SWTextureData*) renderer->target->texture_data)->surface
+                                                     : &data->surface;
+    if (rect->x + rect->w > surface->w || rect->y + rect->h > surface->h) {
+        set_error("Read rectangle is outside the framebuffer");
+        return -1;
+    }
+    for (int row = 0; row < rect->h; row++) {
+        const uint32_t* src = surface->pixels + (size_t)(rect->y + row) * surface->pitch + rect->x;
+        uint32_t* dst = (uint32_t*)((uint8_t*) pixels + (size_t) row * pitch);
+        if (format == sw_output_format(renderer)) {
+            memcpy(dst, src, (size_t) rect->w * 4);
+            continue;
+        }
+        for (int x = 0; x < rect->w; x++) {
+            uint32_t p = src[x];
+            dst[x] = (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+        }
+    }
+    return 0;
+}
+
+// The framebuffer is already in client memory, so this is one copy
+static void sw_capture_frame(BUMI_Renderer* renderer) {
+    BUMI_SWRenderData* data = (BUMI_SWRenderData*) renderer->renderer_data;
+    BUMI_Capture* capture = renderer->capture;
+    if (sw_flush(renderer) != 0) {
+        capture_drop(capture);
+        return;
+    }
+
+    BUMI_CaptureFrame* frame = capture_acquire(capture);
+    if (!frame) {
+        return;
+    }
+    int w = data->surface.w < capture->w ? data->surface.w : capture->w;
+    int h = data->surface.h < capture->h ? data->surface.h : capture->h;
+    capture_fill(capture, frame, (const uint8_t*) data->surface.pixels, data->surface.pitch * 4, w, h, false);
+    capture_submit(capture);
+}
+
+static void sw_end_capture(BUMI_Renderer* renderer) {
+    (void) renderer;
+}
+
+static const BUMI_RenderDriver sw_driver = {
+    "software",
+    BUMI_RENDERER_SOFTWARE,
+    sw_create_renderer,
+    sw_destroy_renderer,
+    sw_clear,
+    sw_fill_rects,
+    sw_fill_rects_instanced,
+    sw_copy,
+    sw_copy_batch,
+    sw_geometry,
+    sw_present,
+    sw_dirty,
+    sw_present_many,
+    sw_create_texture,
+    sw_destroy_texture,
+    sw_update_texture,
+    sw_lock_texture,
+    sw_unlock_texture,
+    sw_set_swap_interval,
+    sw_get_present_timing,
+    sw_repaint,
+    sw_set_target,
+    sw_read_pixels,
+    sw_capture_frame,
+    sw_end_capture
+};
+
+// === RENDERER API ===
+
+static const BUMI_RenderDriver* render_drivers[] = {
+    &gl3_driver,
+    &gl_driver,
+    &sw_driver
+};
+
+#define BUMI_RENDER_DRIVER_COUNT ((int)(sizeof(render_drivers) / sizeof(render_drivers[0])))
+
+int BUMI_GetNumRenderDrivers(void) {
+    return BUMI_RENDER_DRIVER_COUNT;
+}
+
+const char* BUMI_GetRenderDriverName(int index) {
+    if (index < 0 || index >= BUMI_RENDER_DRIVER_COUNT) {
+        set_error("Invalid render driver index %d", index);
+        return NULL;
+    }
+    return render_drivers[index]->name;
+}
+
+static int renderer_valid(const BUMI_Renderer* renderer) {
+    return renderer && renderer->renderer_data && renderer->window && renderer->driver;
+}
+
+BUMI_Renderer* BUMI_RendererCreate(BUMI_Window* window, int index, uint32_t flags) {
+    BUMI_ClearError();
+
+    if (!window) {
+        set_error("Invalid window for renderer creation");
+        return NULL;
+    }
+    if (index >= BUMI_RENDER_DRIVER_COUNT) {
+        set_error("Invalid render driver index %d", index);
+        return NULL;
+    }
+
+    BUMI_Renderer* renderer = (BUMI_Renderer*) pool_alloc(&ctx->renderer_pool);
+    if (!renderer) {
+        set_error("Failed to allocate renderer");
+        return NULL;
+    }
+
+    renderer->window = window;
+    renderer->next = window->renderers;
+    renderer->previous = NULL;
+    renderer->renderer_data = NULL;
+    renderer->draw_color[0] = 0.0f; // Default black
+    renderer->draw_color[1] = 0.0f;
+    renderer->draw_color[2] = 0.0f;
+    renderer->draw_color[3] = 1.0f;
+    renderer->textures = NULL;
+    renderer->driver = NULL;
+    renderer->flags = flags;
+    renderer->target = NULL;
+    renderer->capture = NULL;
+
+    // BUMI_RENDER_DRIVER names a backend when the caller lets us pick one
+    const char* hint = getenv("BUMI_RENDER_DRIVER");
+    if (index < 0 && hint && *hint) {
+        for (int i = 0; i < BUMI_RENDER_DRIVER_COUNT; i++) {
+            if (strcmp(hint, render_drivers[i]->name) == 0) {
+                index = i;
+            }
+        }
+    }
+
+    uint32_t driver_flags = flags & BUMI_RENDERER_DRIVER_FLAGS;
+    if (index >= 0) {
+        if ((render_drivers[index]->flags & driver_flags) == driver_flags &&
+            render_drivers[index]->create_renderer(renderer) == 0) {
+            renderer->driver = render_drivers[index];
+        } else if (!BUMI_GetError()[0]) {
+            set_error("Render driver %s does not support the requested flags", render_drivers[index]->name);
+        }
+    } else {
+        // First backend that satisfies the flags and comes up wins
+        for (int i = 0; i < BUMI_RENDER_DRIVER_COUNT && !renderer->driver; i++) {
+            if ((render_drivers[i]->flags & driver_flags) != driver_flags) {
+                continue;
+            }
+            BUMI_ClearError();
+            if (render_drivers[i]->create_renderer(renderer) == 0) {
+                renderer->driver = render_drivers[i];
+            }
+        }
+        if (!renderer->driver && !BUMI_GetError()[0]) {
+            set_error("No render driver supports the requested flags");
+        }
+    }
+
+    if (!renderer->driver) {
+        pool_free(&ctx->renderer_pool, renderer);
+        return NULL;
+    }
+    BUMI_ClearError();
+
+    if (window->renderers) {
+        window->renderers->previous = renderer;
+    }
+    window->renderers = renderer;
+
+    return renderer;
+}
+
+void BUMI_RendererDestroy(BUMI_Renderer* renderer) {
+    if (!renderer) return;
+
+    BUMI_ClearError();
+
+    if (renderer->capture) {
+        BUMI_RenderStopCapture(renderer);
+    }
+    while (renderer->textures) {
+        BUMI_TextureDestroy(renderer->textures);
+    }
+
+    if (renderer->previous) {
+        renderer->previous->next = renderer->next;
+    } else if (renderer->window) {
+        renderer->window->renderers = renderer->next;
+    }
+    if (renderer->next) {
+        renderer->next->previous = renderer->previous;
+    }
+
+    if (renderer->renderer_data && renderer->driver) {
+        renderer->driver->destroy_renderer(renderer);
+    }
+    pool_free(&ctx->renderer_pool, renderer);
+}
+
+int BUMI_SetRenderDrawColor(BUMI_Renderer* renderer, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    BUMI_ClearError();
+
+    if (!renderer || !renderer->renderer_data) {
+        set_error("Invalid renderer for setting draw color");
+        return -1;
+    }
+
+    renderer->draw_color[0] = r / 255.0f;
+    renderer->draw_color[1] = g / 255.0f;
+    renderer->draw_color[2] = b / 255.0f;
+    renderer->draw_color[3] = a / 255.0f;
+    return 0;
+}
+
+int BUMI_RenderClear(BUMI_Renderer* renderer) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for clearing");
+        return -1;
+    }
+
+    return renderer->driver->clear(renderer);
+}
+
+int BUMI_RenderFillRect(BUMI_Renderer* renderer, const BUMI_Rect* rect) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for drawing rectangle");
+        return -1;
+    }
+
+    BUMI_Rect full = {0, 0, 0, 0};
+    output_size(renderer, &full.w, &full.h);
+    return BUMI_RenderFillRects(renderer, rect ? rect : &full, 1);
+}
+
+int BUMI_RenderFillRects(BUMI_Renderer* renderer, const BUMI_Rect* rects, int count) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for drawing rectangles");
+        return -1;
+    }
+    if (!rects || count < 0) {
+        set_error("Invalid rectangles for drawing");
+        return -1;
+    }
+
+    return renderer->driver->fill_rects(renderer, rects, count);
+}
+
+int BUMI_RenderFillRectsInstanced(BUMI_Renderer* renderer, const BUMI_Rect* rects, const BUMI_Color* colors, int count) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for drawing instances");
+        return -1;
+    }
+    if (!rects || count < 0) {
+        set_error("Invalid instances for drawing");
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    return renderer->driver->fill_rects_instanced(renderer, rects, colors, count);
+}
+
+int BUMI_RenderGeometry(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Vertex* vertices, int num_vertices,
+                        const int* indices, int num_indices) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for drawing geometry");
+        return -1;
+    }
+    if (texture && (texture->renderer->driver != renderer->driver || texture == renderer->target)) {
+        set_error("Geometry texture must come from this render driver and not be the current target");
+        return -1;
+    }
+    int count = indices ? num_indices : num_vertices;
+    if (!vertices || num_vertices < 0 || count < 0 || count % 3 != 0) {
+        set_error("Invalid vertices for drawing geometry");
+        return -1;
+    }
+    for (int i = 0; indices && i < num_indices; i++) {
+        if (indices[i] < 0 || indices[i] >= num_vertices) {
+            set_error("Geometry index %d out of range", indices[i]);
+            return -1;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    return renderer->driver->geometry(renderer, texture, vertices, num_vertices, indices, num_indices);
+}
+
+// Lines and points are built as quads in frame memory and submitted as
+// one geometry call
+static void primitive_quad(BUMI_Vertex* v, int* indices, int base, const float xs[4], const float ys[4],
+                           const BUMI_Color* color) {
+    static const int quad[6] = {0, 1, 2, 0, 2, 3};
+    for (int k = 0; k < 4; k++) {
+        v[k].x = xs[k];
+        v[k].y = ys[k];
+        v[k].color = *color;
+        v[k].u = v[k].v = 0.0f;
+    }
+    for (int k = 0; k < 6; k++) {
+        indices[k] = base + quad[k];
+    }
+}
+
+static BUMI_Color primitive_color(const BUMI_Renderer* renderer) {
+    uint8_t c[4];
+    draw_color_bytes(renderer, c);
+    BUMI_Color color = {c[0], c[1], c[2], c[3]};
+    return color;
+}
+
+int BUMI_RenderPoints(BUMI_Renderer* renderer, const BUMI_Point* points, int count) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for drawing points");
+        return -1;
+    }
+    if (!points || count < 0) {
+        set_error("Invalid points for drawing");
+        return -1;
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t mark = frame_mark();
+    BUMI_Vertex* vertices = (BUMI_Vertex*) frame_alloc((size_t) count * 4 * sizeof(BUMI_Vertex));
+    int* indices = (int*) frame_alloc((size_t) count * 6 * sizeof(int));
+    if (!vertices || !indices) {
+        frame_release(mark);
+        return -1;
+    }
+    BUMI_Color color = primitive_color(renderer);
+    for (int i = 0; i < count; i++) {
+        float x = (float) points[i].x;
+        float y = (float) points[i].y;
+        const float xs[4] = {x, x + 1, x + 1, x};
+        const float ys[4] = {y, y, y + 1, y + 1};
+        primitive_quad(&vertices[i * 4], &indices[i * 6], i * 4, xs, ys, &color);
+    }
+    int result = renderer->driver->geometry(renderer, NULL, vertices, count * 4, indices, count * 6);
+    frame_release(mark);
+    return result;
+}
+
+int BUMI_RenderLines(BUMI_Renderer* renderer, const BUMI_Point* points, int count) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for drawing lines");
+        return -1;
+    }
+    if (!points || count < 0) {
+        set_error("Invalid points for drawing lines");
+        return -1;
+    }
+    if (count <= 1) {
+        return BUMI_RenderPoints(renderer, points, count);
+    }
+
+    // Each segment is a quad one pixel across, running between pixel centers
+    // and extended half a pixel past both ends so joints have no gaps
+    int segments = count - 1;
+    size_t mark = frame_mark();
+    BUMI_Vertex* vertices = (BUMI_Vertex*) frame_alloc((size_t) segments * 4 * sizeof(BUMI_Vertex));
+    int* indices = (int*) frame_alloc((size_t) segments * 6 * sizeof(int));
+    if (!vertices || !indices) {
+        frame_release(mark);
+        return -1;
+    }
+    BUMI_Color color = primitive_color(renderer);
+    for (int i = 0; i < segments; i++) {
+        float x0 = points[i].x + 0.5f, y0 = points[i].y + 0.5f;
+        float x1 = points[i + 1].x + 0.5f, y1 = points[i + 1].y + 0.5f;
+        float dx = x1 - x0, dy = y1 - y0;
+        float length = sqrtf(dx * dx + dy * dy);
+        if (length == 0) {
+            dx = 0.5f;
+            dy = 0.0f;
+        } else {
+            dx *= 0.5f / length;
+            dy *= 0.5f / length;
+        }
+        // (dx, dy) is half a pixel along the segment, (-dy, dx) across it
+        const float xs[4] = {x0 - dx + dy, x1 + dx + dy, x1 + dx - dy, x0 - dx - dy};
+        const float ys[4] = {y0 - dy - dx, y1 + dy - dx, y1 + dy + dx, y0 - dy + dx};
+        primitive_quad(&vertices[i * 4], &indices[i * 6], i * 4, xs, ys, &color);
+    }
+    int result = renderer->driver->geometry(renderer, NULL, vertices, segments * 4, indices, segments * 6);
+    frame_release(mark);
+    return result;
+}
+
+void BUMI_RenderPresent(BUMI_Renderer* renderer) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for presenting");
+        return;
+    }
+    if (renderer->target) {
+        set_error("Cannot present while a render target is set");
+        return;
+    }
+
+    if (renderer->capture) {
+        renderer->driver->capture_frame(renderer);
+    }
+
+    renderer->driver->present(renderer);
+    frame_release(0);
+    if (!ctx->first_present_ns) {
+        ctx->first_present_ns = monotonic_ns();
+    }
+}
+
+int BUMI_RenderPresentAll(void) {
+    BUMI_ClearError();
+
+    if (!ctx) {
+        set_error("Presenting requires initialized context");
+        return -1;
+    }
+
+    int presented = 0;
+    for (int d = 0; d < BUMI_RENDER_DRIVER_COUNT; d++) {
+        const BUMI_RenderDriver* driver = render_drivers[d];
+        int count = 0;
+        for (BUMI_Window* window = ctx->windows; window; window = window->next) {
+            for (BUMI_Renderer* renderer = window->renderers; renderer; renderer = renderer->next) {
+                if (renderer->driver != driver || renderer->target || !driver->dirty(renderer)) {
+                    continue;
+                }
+                if (count == ctx->present_capacity) {
+                    int capacity = ctx->present_capacity ? ctx->present_capacity * 2 : 64;
+                    BUMI_Renderer** list = (BUMI_Renderer**) BUMI_internal_realloc(ctx->present_list,
+                                                                     (size_t) capacity * sizeof(BUMI_Renderer*));
+                    if (!list) {
+                        set_error("Failed to allocate present list");
+                        return -1;
+                    }
+                    ctx->present_list = list;
+                    ctx->present_capacity = capacity;
+                }
+                ctx->present_list[count++] = renderer;
+            }
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        // Readback happens in each captured renderer's own context
+        for (int i = 0; i < count; i++) {
+            if (ctx->present_list[i]->capture) {
+                driver->capture_frame(ctx->present_list[i]);
+            }
+        }
+        driver->present_many(ctx->present_list, count);
+        presented += count;
+    }
+    frame_release(0);
+    if (presented && !ctx->first_present_ns) {
+        ctx->first_present_ns = monotonic_ns();
+    }
+    return presented;
+}
+
+static void capture_destroy(BUMI_Capture* capture) {
+    for (int i = 0; i < BUMI_CAPTURE_QUEUE; i++) {
+        BUMI_internal_free(capture->frames[i].pixels);
+    }
+    BUMI_internal_free(capture->yuv);
+    if (capture->file) {
+        fclose(capture->file);
+    }
+    BUMI_internal_free(capture);
+}
+
+int BUMI_RenderStartCapture(BUMI_Renderer* renderer, const char* path, int format, int fps) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for capture");
+        return -1;
+    }
+    if (renderer->capture) {
+        set_error("Renderer is already capturing");
+        return -1;
+    }
+    if (!path || (format != BUMI_CAPTURE_Y4M && format != BUMI_CAPTURE_RAW) || fps <= 0) {
+        set_error("Invalid capture parameters");
+        return -1;
+    }
+    if (renderer->window->w <= 0 || renderer->window->h <= 0) {
+        set_error("Cannot capture an empty window");
+        return -1;
+    }
+
+    BUMI_Capture* capture = (BUMI_Capture*) BUMI_internal_calloc(1, sizeof(BUMI_Capture));
+    if (!capture) {
+        set_error("Failed to allocate capture");
+        return -1;
+    }
+    capture->format = format;
+    capture->w = renderer->window->w;
+    capture->h = renderer->window->h;
+
+    size_t frame_size = (size_t) capture->w * capture->h * 4;
+    for (int i = 0; i < BUMI_CAPTURE_QUEUE; i++) {
+        capture->frames[i].pixels = (uint8_t*) BUMI_internal_malloc(frame_size);
+        if (!capture->frames[i].pixels) {
+            capture_destroy(capture);
+            set_error("Failed to allocate capture frames");
+            return -1;
+        }
+    }
+    if (format == BUMI_CAPTURE_Y4M) {
+        size_t chroma = (size_t)((capture->w + 1) / 2) * ((capture->h + 1) / 2);
+        capture->yuv = (uint8_t*) BUMI_internal_malloc((size_t) capture->w * capture->h + chroma * 2);
+        if (!capture->yuv) {
+            capture_destroy(capture);
+            set_error("Failed to allocate capture frames");
+            return -1;
+        }
+    }
+
+    capture->file = fopen(path, "wb");
+    if (!capture->file) {
+        set_error("Failed to open %s: %s", path, strerror(errno));
+        capture_destroy(capture);
+        return -1;
+    }
+    // Flushed so a full disk shows up here rather than as a headerless stream
+    if (format == BUMI_CAPTURE_Y4M &&
+        (fprintf(capture->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", capture->w, capture->h, fps) < 0 ||
+         fflush(capture->file) != 0)) {
+        set_error("Failed to write the Y4M header to %s: %s", path, strerror(errno));
+        capture_destroy(capture);
+        return -1;
+    }
+
+    pthread_mutex_init(&capture->lock, NULL);
+    pthread_cond_init(&capture->ready, NULL);
+    if (pthread_create(&capture->thread, NULL, capture_writer_main, capture) != 0) {
+        pthread_cond_destroy(&capture->ready);
+        pthread_mutex_destroy(&capture->lock);
+        capture_destroy(capture);
+        set_error("Failed to start capture writer thread");
+        return -1;
+    }
+
+    renderer->capture = capture;
+    return 0;
+}
+
+int BUMI_RenderStopCapture(BUMI_Renderer* renderer) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer) || !renderer->capture) {
+        set_error("Renderer is not capturing");
+        return -1;
+    }
+
+    BUMI_Capture* capture = renderer->capture;
+    renderer->driver->end_capture(renderer);
+    renderer->capture = NULL;
+
+    // The writer drains the queue before it sees quit
+    pthread_mutex_lock(&capture->lock);
+    capture->quit = true;
+    pthread_cond_signal(&capture->ready);
+    pthread_mutex_unlock(&capture->lock);
+    pthread_join(capture->thread, NULL);
+    pthread_cond_destroy(&capture->ready);
+    pthread_mutex_destroy(&capture->lock);
+
+    bool failed = fclose(capture->file) != 0 || capture->write_failed;
+    capture->file = NULL;
+    capture_destroy(capture);
+    if (failed) {
+        set_error("Failed to write capture file");
+        return -1;
+    }
+    return 0;
+}
+
+int BUMI_RenderGetCaptureStats(BUMI_Renderer* renderer, BUMI_CaptureStats* stats) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer) || !renderer->capture || !stats) {
+        set_error("Renderer is not capturing");
+        return -1;
+    }
+
+    BUMI_Capture* capture = renderer->capture;
+    pthread_mutex_lock(&capture->lock);
+    stats->captured = capture->captured;
+    stats->written = capture->written;
+    stats->dropped = capture->dropped;
+    pthread_mutex_unlock(&capture->lock);
+    return 0;
+}
+
+int BUMI_SetSwapInterval(BUMI_Renderer* renderer, int interval) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for setting swap interval");
+        return -1;
+    }
+
+    return renderer->driver->set_swap_interval(renderer, interval);
+}
+
+int BUMI_GetPresentTiming(BUMI_Renderer* renderer, BUMI_PresentTiming* timing) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer) || !timing) {
+        set_error("Invalid renderer for present timing");
+        return -1;
+    }
+
+    return renderer->driver->get_present_timing(renderer, timing);
+}
+
+static int texture_rect(const BUMI_Texture* texture, const BUMI_Rect* rect, BUMI_Rect* out) {
+    if (!rect) {
+        out->x = out->y = 0;
+        out->w = texture->w;
+        out->h = texture->h;
+        return 1;
+    }
+    if (rect->x < 0 || rect->y < 0 || rect->w <= 0 || rect->h <= 0 ||
+        rect->x + rect->w > texture->w || rect->y + rect->h > texture->h) {
+        return 0;
+    }
+    *out = *rect;
+    return 1;
+}
+
+BUMI_Texture* BUMI_TextureCreate(BUMI_Renderer* renderer, uint32_t format, int access, int w, int h) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for texture creation");
+        return NULL;
+    }
+    if (format != BUMI_PIXELFORMAT_RGBA32 && format != BUMI_PIXELFORMAT_BGRA32) {
+        set_error("Unsupported texture pixel format");
+        return NULL;
+    }
+    if (access != BUMI_TEXTUREACCESS_STATIC && access != BUMI_TEXTUREACCESS_STREAMING &&
+        access != BUMI_TEXTUREACCESS_TARGET) {
+        set_error("Unsupported texture access");
+        return NULL;
+    }
+    if (w <= 0 || h <= 0) {
+        set_error("Invalid texture size %dx%d", w, h);
+        return NULL;
+    }
+
+    BUMI_Texture* texture = (BUMI_Texture*) BUMI_internal_calloc(1, sizeof(BUMI_Texture));
+    if (!texture) {
+        set_error("Failed to allocate texture");
+        return NULL;
+    }
+
+    texture->renderer = renderer;
+    texture->format = format;
+    texture->access = access;
+    texture->w = w;
+    texture->h = h;
+    if (renderer->driver->create_texture(texture) != 0) {
+        BUMI_internal_free(texture);
+        return NULL;
+    }
+
+    texture->next = renderer->textures;
+    texture->previous = NULL;
+    if (renderer->textures) {
+        renderer->textures->previous = texture;
+    }
+    renderer->textures = texture;
+    return texture;
+}
+
+void BUMI_TextureDestroy(BUMI_Texture* texture) {
+    if (!texture) return;
+
+    BUMI_ClearError();
+
+    BUMI_Renderer* renderer = texture->renderer;
+    if (renderer->target == texture) {
+        BUMI_SetRenderTarget(renderer, NULL);
+    }
+    renderer->driver->destroy_texture(texture);
+
+    if (texture->previous) {
+        texture->previous->next = texture->next;
+    } else {
+        renderer->textures = texture->next;
+    }
+    if (texture->next) {
+        texture->next->previous = texture->previous;
+    }
+    BUMI_internal_free(texture);
+}
+
+int BUMI_TextureUpdate(BUMI_Texture* texture, const BUMI_Rect* rect, const void* pixels, int pitch) {
+    BUMI_ClearError();
+
+    if (!texture || !texture->texture_data || !pixels) {
+        set_error("Invalid texture update");
+        return -1;
+    }
+
+    BUMI_Rect area;
+    if (!texture_rect(texture, rect, &area)) {
+        set_error("Texture update rectangle out of bounds");
+        return -1;
+    }
+    if (pitch < area.w * 4 || pitch % 4 != 0) {
+        set_error("Invalid texture update pitch %d", pitch);
+        return -1;
+    }
+
+    return texture->renderer->driver->update_texture(texture, &area, pixels, pitch);
+}
+
+int BUMI_TextureLock(BUMI_Texture* texture, const BUMI_Rect* rect, void** pixels, int* pitch) {
+    BUMI_ClearError();
+
+    if (!texture || !texture->texture_data || !pixels || !pitch) {
+        set_error("Invalid texture lock");
+        return -1;
+    }
+    if (texture->access != BUMI_TEXTUREACCESS_STREAMING) {
+        set_error("Only streaming textures can be locked");
+        return -1;
+    }
+
+    BUMI_Rect area;
+    if (!texture_rect(texture, rect, &area)) {
+        set_error("Texture lock rectangle out of bounds");
+        return -1;
+    }
+
+    return texture->renderer->driver->lock_texture(texture, &area, pixels, pitch);
+}
+
+void BUMI_TextureUnlock(BUMI_Texture* texture) {
+    BUMI_ClearError();
+
+    if (!texture || !texture->texture_data) {
+        set_error("Invalid texture unlock");
+        return;
+    }
+
+    texture->renderer->driver->unlock_texture(texture);
+}
+
+int BUMI_RenderCopy(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Rect* src, const BUMI_Rect* dst) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for texture copy");
+        return -1;
+    }
+    // Renderers on the same driver share textures across windows
+    if (!texture || texture->renderer->driver != renderer->driver) {
+        set_error("Texture was created on a different render driver");
+        return -1;
+    }
+
+    BUMI_Rect area;
+    if (!texture_rect(texture, src, &area)) {
+        set_error("Texture source rectangle out of bounds");
+        return -1;
+    }
+    if (texture == renderer->target) {
+        set_error("Cannot copy from the current render target");
+        return -1;
+    }
+    BUMI_Rect full = {0, 0, 0, 0};
+    output_size(renderer, &full.w, &full.h);
+
+    return renderer->driver->copy(renderer, texture, &area, dst ? dst : &full);
+}
+
+int BUMI_SetRenderTarget(BUMI_Renderer* renderer, BUMI_Texture* texture) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for setting render target");
+        return -1;
+    }
+    if (texture && (texture->renderer != renderer || texture->access != BUMI_TEXTUREACCESS_TARGET)) {
+        set_error("Render target must be a BUMI_TEXTUREACCESS_TARGET texture of this renderer");
+        return -1;
+    }
+    if (texture == renderer->target) {
+        return 0;
+    }
+
+    if (renderer->driver->set_target(renderer, texture) != 0) {
+        return -1;
+    }
+    renderer->target = texture;
+    return 0;
+}
+
+int BUMI_RenderReadPixels(BUMI_Renderer* renderer, const BUMI_Rect* rect, uint32_t format, void* pixels, int pitch) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for reading pixels");
+        return -1;
+    }
+    if (format != BUMI_PIXELFORMAT_RGBA32 && format != BUMI_PIXELFORMAT_BGRA32) {
+        set_error("Unsupported read pixel format");
+        return -1;
+    }
+
+    BUMI_Rect bounds = {0, 0, 0, 0};
+    output_size(renderer, &bounds.w, &bounds.h);
+    BUMI_Rect area;
+    if (!rect) {
+        area = bounds;
+    } else if (!rect_intersect(rect, &bounds, &area) || area.w != rect->w || area.h != rect->h) {
+        set_error("Read rectangle is outside the render output");
+        return -1;
+    }
+    if (!pixels || pitch < area.w * 4 || pitch % 4 != 0) {
+        set_error("Invalid pixel buffer for reading");
+        return -1;
+    }
+
+    return renderer->driver->read_pixels(renderer, &area, format, pixels, pitch);
+}
+
+// === TEXTURE ATLAS ===
+
+// Pages are packed with a bottom-left skyline: the top edge of the used area
+// is kept as a list of horizontal segments, and each image goes where it
+// rests lowest. One pixel of padding keeps filtering from bleeding across
+// neighbouring images.
+#define BUMI_ATLAS_PADDING 1
+
+typedef struct {
+    int x, y, w;
+} BUMI_SkylineNode;
+
+typedef struct {
+    BUMI_Texture* texture;
+    BUMI_SkylineNode* nodes;
+    int node_count;
+    int node_capacity;
+} BUMI_AtlasPage;
+
+typedef struct {
+    int page;
+    BUMI_Rect rect;
+} BUMI_AtlasSprite;
+
+struct BUMI_Atlas {
+    BUMI_Renderer* renderer;
+    uint32_t format;
+    int page_w, page_h;
+    BUMI_AtlasPage* pages;
+    int page_count;
+    BUMI_AtlasSprite* sprites;
+    int sprite_count;
+    int sprite_capacity;
+};
+
+// Lowest y at which a w x h box starting at node `index` fits, or -1
+static int skyline_fit(const BUMI_Atlas* atlas, const BUMI_AtlasPage* page, int index, int w, int h) {
+    int x = page->nodes[index].x;
+    if (x + w > atlas->page_w) {
+        return -1;
+    }
+
+    int y = 0;
+    int remaining = w;
+    for (int i = index; remaining > 0; i++) {
+        if (i >= page->node_count) {
+            return -1;
+        }
+        if (page->nodes[i].y > y) {
+            y = page->nodes[i].y;
+        }
+        if (y + h > atlas->page_h) {
+            return -1;
+        }
+        remaining -= page->nodes[i].w;
+    }
+    return y;
+}
+
+static int skyline_insert(BUMI_AtlasPage* page, int index, int x, int y, int w) {
+    if (page->node_count == page->node_capacity) {
+        int capacity = page->node_capacity ? page->node_capacity * 2 : 32;
+        BUMI_SkylineNode* nodes =
+            (BUMI_SkylineNode*) BUMI_internal_realloc(page->nodes, capacity * sizeof(BUMI_SkylineNode));
+        if (!nodes) {
+            return 0;
+        }
+        page->nodes = nodes;
+        page->node_capacity = capacity;
+    }
+
+    memmove(&page->nodes[index + 1], &page->nodes[index], (page->node_count - index) * sizeof(BUMI_SkylineNode));
+    page->nodes[index].x = x;
+    page->nodes[index].y = y;
+    page->nodes[index].w = w;
+    page->node_count++;
+
+    // Trim or drop the segments the new one now covers
+    for (int i = index + 1; i < page->node_count; i++) {
+        BUMI_SkylineNode* prev = &page->nodes[i - 1];
+        BUMI_SkylineNode* node = &page->nodes[i];
+        int shrink = prev->x + prev->w - node->x;
+        if (shrink <= 0) {
+            break;
+        }
+        node->x += shrink;
+        node->w -= shrink;
+        if (node->w > 0) {
+            break;
+        }
+        memmove(node, node + 1, (page->node_count - i - 1) * sizeof(BUMI_SkylineNode));
+        page->node_count--;
+        i--;
+    }
+
+    // Merge neighbours left at the same height
+    for (int i = 0; i + 1 < page->node_count; i++) {
+        if (page->nodes[i].y == page->nodes[i + 1].y) {
+            page->nodes[i].w += page->nodes[i + 1].w;
+            memmove(&page->nodes[i + 1], &page->nodes[i + 2], (page->node_count - i - 2) * sizeof(BUMI_SkylineNode));
+            page->node_count--;
+            i--;
+        }
+    }
+    return 1;
+}
+
+// Reserve a w x h area on `page`, preferring the lowest then narrowest spot
+static int skyline_pack(BUMI_Atlas* atlas, BUMI_AtlasPage* page, int w, int h, BUMI_Rect* out) {
+    int best = -1, best_y = 0, best_w = 0;
+    for (int i = 0; i < page->node_count; i++) {
+        int y = skyline_fit(atlas, page, i, w, h);
+        if (y < 0) {
+            continue;
+        }
+        if (best < 0 || y < best_y || (y == best_y && page->nodes[i].w < best_w)) {
+            best = i;
+            best_y = y;
+            best_w = page->nodes[i].w;
+        }
+    }
+    if (best < 0) {
+        return 0;
+    }
+
+    out->x = page->nodes[best].x;
+    out->y = best_y;
+    out->w = w;
+    out->h = h;
+    return skyline_insert(page, best, out->x, best_y + h, w);
+}
+
+static BUMI_AtlasPage* atlas_add_page(BUMI_Atlas* atlas) {
+    BUMI_AtlasPage* pages =
+        (BUMI_AtlasPage*) BUMI_internal_realloc(atlas->pages, (atlas->page_count + 1) * sizeof(BUMI_AtlasPage));
+    if (!pages) {
+        set_error("Failed to allocate atlas page");
+        return NULL;
+    }
+    atlas->pages = pages;
+
+    BUMI_AtlasPage* page = &atlas->pages[atlas->page_count];
+    memset(page, 0, sizeof(*page));
+    page->nodes = (BUMI_SkylineNode*) BUMI_internal_malloc(32 * sizeof(BUMI_SkylineNode));
+    if (!page->nodes) {
+        set_error("Failed to allocate atlas page");
+        return NULL;
+    }
+    page->node_capacity = 32;
+    page->node_count = 1;
+    page->nodes[0].x = 0;
+    page->nodes[0].y = 0;
+    page->nodes[0].w = atlas->page_w;
+
+    page->texture = BUMI_TextureCreate(atlas->renderer, atlas->format, BUMI_TEXTUREACCESS_STATIC, atlas->page_w, atlas->page_h);
+    if (!page->texture) {
+        BUMI_internal_free(page->nodes);
+        return NULL;
+    }
+    atlas->page_count++;
+    return page;
+}
+
+BUMI_Atlas* BUMI_AtlasCreate(BUMI_Renderer* renderer, uint32_t format, int page_w, int page_h) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for atlas creation");
+        return NULL;
+    }
+    if (page_w <= 0 || page_h <= 0) {
+        set_error("Invalid atlas page size %dx%d", page_w, page_h);
+        return NULL;
+    }
+    if (format != BUMI_PIXELFORMAT_RGBA32 && format != BUMI_PIXELFORMAT_BGRA32) {
+        set_error("Unsupported atlas pixel format");
+        return NULL;
+    }
+
+    BUMI_Atlas* atlas = (BUMI_Atlas*) BUMI_internal_calloc(1, sizeof(BUMI_Atlas));
+    if (!atlas) {
+        set_error("Failed to allocate atlas");
+        return NULL;
+    }
+    atlas->renderer = renderer;
+    atlas->format = format;
+    atlas->page_w = page_w;
+    atlas->page_h = page_h;
+    return atlas;
+}
+
+void BUMI_AtlasDestroy(BUMI_Atlas* atlas) {
+    if (!atlas) return;
+
+    for (int i = 0; i < atlas->page_count; i++) {
+        BUMI_TextureDestroy(atlas->pages[i].texture);
+        BUMI_internal_free(atlas->pages[i].nodes);
+    }
+    BUMI_internal_free(atlas->pages);
+    BUMI_internal_free(atlas->sprites);
+    BUMI_internal_free(atlas);
+}
+
+int BUMI_AtlasAdd(BUMI_Atlas* atlas, const void* pixels, int w, int h, int pitch) {
+    BUMI_ClearError();
+
+    if (!atlas || !pixels) {
+        set_error("Invalid atlas image");
+        return -1;
+    }
+    if (w <= 0 || h <= 0 || w + BUMI_ATLAS_PADDING > atlas->page_w || h + BUMI_ATLAS_PADDING > atlas->page_h) {
+        set_error("Image of %dx%d does not fit an atlas page", w, h);
+        return -1;
+    }
+
+    if (atlas->sprite_count == atlas->sprite_capacity) {
+        int capacity = atlas->sprite_capacity ? atlas->sprite_capacity * 2 : 64;
+        BUMI_AtlasSprite* sprites =
+            (BUMI_AtlasSprite*) BUMI_internal_realloc(atlas->sprites, capacity * sizeof(BUMI_AtlasSprite));
+        if (!sprites) {
+            set_error("Failed to grow atlas sprite table");
+            return -1;
+        }
+        atlas->sprites = sprites;
+        atlas->sprite_capacity = capacity;
+    }
+
+    // Try the existing pages newest first, then open a new one
+    BUMI_AtlasSprite* sprite = &atlas->sprites[atlas->sprite_count];
+    BUMI_Rect area;
+    sprite->page = -1;
+    for (int i = atlas->page_count - 1; i >= 0 && sprite->page < 0; i--) {
+        if (skyline_pack(atlas, &atlas->pages[i], w + BUMI_ATLAS_PADDING, h + BUMI_ATLAS_PADDING, &area)) {
+            sprite->page = i;
+        }
+    }
+    if (sprite->page < 0) {
+        BUMI_AtlasPage* page = atlas_add_page(atlas);
+        if (!page || !skyline_pack(atlas, page, w + BUMI_ATLAS_PADDING, h + BUMI_ATLAS_PADDING, &area)) {
+            return -1;
+        }
+        sprite->page = atlas->page_count - 1;
+    }
+
+    sprite->rect.x = area.x;
+    sprite->rect.y = area.y;
+    sprite->rect.w = w;
+    sprite->rect.h = h;
+    if (BUMI_TextureUpdate(atlas->pages[sprite->page].texture, &sprite->rect, pixels, pitch) != 0) {
+        return -1;
+    }
+    return atlas->sprite_count++;
+}
+
+int BUMI_AtlasGetSprite(const BUMI_Atlas* atlas, int sprite, BUMI_Texture** page, BUMI_Rect* rect) {
+    if (!atlas || sprite < 0 || sprite >= atlas->sprite_count) {
+        set_error("Invalid atlas sprite %d", sprite);
+        return -1;
+    }
+    if (page) {
+        *page = atlas->pages[atlas->sprites[sprite].page].texture;
+    }
+    if (rect) {
+        *rect = atlas->sprites[sprite].rect;
+    }
+    return 0;
+}
+
+int BUMI_RenderSprite(BUMI_Renderer* renderer, BUMI_Atlas* atlas, int sprite, const BUMI_Rect* dst) {
+    return BUMI_RenderSprites(renderer, atlas, &sprite, dst, 1);
+}
+
+int BUMI_RenderSprites(BUMI_Renderer* renderer, BUMI_Atlas* atlas, const int* sprites, const BUMI_Rect* dsts, int count) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for sprite drawing");
+        return -1;
+    }
+    if (!atlas || atlas->renderer->driver != renderer->driver) {
+        set_error("Atlas was created on a different render driver");
+        return -1;
+    }
+    if (!sprites || !dsts || count < 0) {
+        set_error("Invalid sprites for drawing");
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        if (sprites[i] < 0 || sprites[i] >= atlas->sprite_count) {
+            set_error("Invalid atlas sprite %d", sprites[i]);
+            return -1;
+        }
+    }
+
+    // Walk the list once per page so every page's sprites land in one batch
+    for (int page = 0; page < atlas->page_count; page++) {
+        BUMI_Texture* texture = atlas->pages[page].texture;
+        for (int i = 0; i < count; i++) {
+            const BUMI_AtlasSprite* sprite = &atlas->sprites[sprites[i]];
+            if (sprite->page != page) {
+                continue;
+            }
+            if (renderer->driver->copy(renderer, texture, &sprite->rect, &dsts[i]) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// === TEXT ===
+
+// Built-in 5x7 font for printable ASCII (0x20-0x7E). Row-major, bit 4 is
+// the leftmost column
+#define BUMI_FONT_GLYPH_W 5
+#define BUMI_FONT_GLYPH_H 7
+#define BUMI_FONT_ADVANCE 6  // Glyph plus one column of spacing
+#define BUMI_FONT_LINE 9     // Glyph plus two rows of leading
+
+static const uint8_t font5x7[95][BUMI_FONT_GLYPH_H] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // space
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, // !
+    {0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00}, // "
+    {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A}, // #
+    {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04}, // $
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, // %
+    {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D}, // &
+    {0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00}, // '
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, // (
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, // )
+    {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00}, // *
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}, // +
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}, // ,
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // -
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // .
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // /
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // 0
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 1
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // 2
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // 3
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // 4
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // 5
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // 6
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // 7
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // 8
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // 9
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // :
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08}, // ;
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}, // <
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}, // =
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}, // >
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}, // ?
+    {0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E}, // @
+    {0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11}, // A
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // B
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // C
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // D
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // E
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // F
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // G
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // H
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // I
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // J
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // K
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // L
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // M
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // N
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // O
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // P
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // Q
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // R
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // S
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // T
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // U
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // V
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // W
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // X
+    {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04}, // Y
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // Z
+    {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E}, // [
+    {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00}, // backslash
+    {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E}, // ]
+    {0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00}, // ^
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F}, // _
+    {0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00}, // `
+    {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F}, // a
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E}, // b
+    {0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E}, // c
+    {0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F}, // d
+    {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E}, // e
+    {0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08}, // f
+    {0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E}, // g
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11}, // h
+    {0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E}, // i
+    {0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C}, // j
+    {0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12}, // k
+    {0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // l
+    {0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11}, // m
+    {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11}, // n
+    {0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E}, // o
+    {0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10}, // p
+    {0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01}, // q
+    {0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10}, // r
+    {0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E}, // s
+    {0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06}, // t
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D}, // u
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04}, // v
+    {0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A}, // w
+    {0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11}, // x
+    {0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E}, // y
+    {0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F}, // z
+    {0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02}, // {
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // |
+    {0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08}, // }
+    {0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00}, // ~
+};
+
+// Drawn for codepoints the font has no glyph for
+static const uint8_t font5x7_missing[BUMI_FONT_GLYPH_H] = {0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F};
+
+// Glyphs are rasterized on first use into fixed cells of one texture.
+// When every cell is taken, the least recently drawn glyph gives up its
+// cell. Cells carry a transparent border so filtering never picks up a
+// neighbour
+#define BUMI_GLYPH_CACHE_COLS 16
+#define BUMI_GLYPH_CACHE_ROWS 8
+#define BUMI_GLYPH_CACHE_CELLS (BUMI_GLYPH_CACHE_COLS * BUMI_GLYPH_CACHE_ROWS)
+#define BUMI_GLYPH_HASH_SIZE 256
+#define BUMI_GLYPH_BORDER 1
+#define BUMI_TEXT_BATCH 256  // Quads handed to the driver at a time
+
+typedef struct {
+    uint32_t codepoint;
+    bool valid;
+    uint32_t serial;         // BUMI_RenderText call that last drew it
+    int hash_next;           // Next cell in the same bucket
+    int lru_prev, lru_next;  // Towards the most / least recently used end
+} BUMI_GlyphCell;
+
+struct BUMI_Font {
+    BUMI_Renderer* renderer;
+    BUMI_Texture* texture;
+    int scale;
+    int cell_w, cell_h;
+    BUMI_GlyphCell cells[BUMI_GLYPH_CACHE_CELLS];
+    int buckets[BUMI_GLYPH_HASH_SIZE];
+    int lru_head, lru_tail;  // Most / least recently used cell
+    uint32_t serial;
+    uint32_t* scratch;       // One cell of pixels for rasterizing
+    uint64_t hits, misses;
+};
+
+static void glyph_lru_unlink(BUMI_Font* font, int cell) {
+    BUMI_GlyphCell* c = &font->cells[cell];
+    if (c->lru_prev >= 0) font->cells[c->lru_prev].lru_next = c->lru_next;
+    else font->lru_head = c->lru_next;
+    if (c->lru_next >= 0) font->cells[c->lru_next].lru_prev = c->lru_prev;
+    else font->lru_tail = c->lru_prev;
+}
+
+static void glyph_lru_push_front(BUMI_Font* font, int cell) {
+    BUMI_GlyphCell* c = &font->cells[cell];
+    c->lru_prev = -1;
+    c->lru_next = font->lru_head;
+    if (font->lru_head >= 0) font->cells[font->lru_head].lru_prev = cell;
+    font->lru_head = cell;
+    if (font->lru_tail < 0) font->lru_tail = cell;
+}
+
+static int glyph_find(const BUMI_Font* font, uint32_t codepoint) {
+    int cell = font->buckets[codepoint % BUMI_GLYPH_HASH_SIZE];
+    while (cell >= 0 && font->cells[cell].codepoint != codepoint) {
+        cell = font->cells[cell].hash_next;
+    }
+    return cell;
+}
+
+static void glyph_unhash(BUMI_Font* font, int cell) {
+    int* link = &font->buckets[font->cells[cell].codepoint % BUMI_GLYPH_HASH_SIZE];
+    while (*link != cell) {
+        link = &font->cells[*link].hash_next;
+    }
+    *link = font->cells[cell].hash_next;
+}
+
+static void glyph_cell_rect(const BUMI_Font* font, int cell, BUMI_Rect* rect) {
+    rect->x = (cell % BUMI_GLYPH_CACHE_COLS) * font->cell_w + BUMI_GLYPH_BORDER;
+    rect->y = (cell / BUMI_GLYPH_CACHE_COLS) * font->cell_h + BUMI_GLYPH_BORDER;
+    rect->w = BUMI_FONT_GLYPH_W * font->scale;
+    rect->h = BUMI_FONT_GLYPH_H * font->scale;
+}
+
+// Rasterize `codepoint` into the least recently used cell. Opaque white
+// where the glyph is set; the draw color is applied when it is copied
+static int glyph_load(BUMI_Font* font, int cell, uint32_t codepoint) {
+    const uint8_t* rows = codepoint >= 0x20 && codepoint < 0x7F ? font5x7[codepoint - 0x20] : font5x7_missing;
+    int w = font->cell_w;
+    for (int y = 0; y < font->cell_h; y++) {
+        for (int x = 0; x < w; x++) {
+            int gx = (x - BUMI_GLYPH_BORDER) / font->scale;
+            int gy = (y - BUMI_GLYPH_BORDER) / font->scale;
+            bool set = x >= BUMI_GLYPH_BORDER && y >= BUMI_GLYPH_BORDER && gx < BUMI_FONT_GLYPH_W &&
+                       gy < BUMI_FONT_GLYPH_H && (rows[gy] & (0x10 >> gx));
+            font->scratch[y * w + x] = set ? 0xFFFFFFFFu : 0x00FFFFFFu;
+        }
+    }
+
+    BUMI_Rect rect = {(cell % BUMI_GLYPH_CACHE_COLS) * font->cell_w, (cell / BUMI_GLYPH_CACHE_COLS) * font->cell_h,
+                      font->cell_w, font->cell_h};
+    return BUMI_TextureUpdate(font->texture, &rect, font->scratch, w * 4);
+}
+
+BUMI_Font* BUMI_FontCreate(BUMI_Renderer* renderer, int scale) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for font creation");
+        return NULL;
+    }
+    if (scale < 1 || scale > 16) {
+        set_error("Invalid font scale %d", scale);
+        return NULL;
+    }
+
+    BUMI_Font* font = (BUMI_Font*) BUMI_internal_calloc(1, sizeof(BUMI_Font));
+    if (!font) {
+        set_error("Failed to allocate font");
+        return NULL;
+    }
+    font->renderer = renderer;
+    font->scale = scale;
+    font->cell_w = BUMI_FONT_GLYPH_W * scale + 2 * BUMI_GLYPH_BORDER;
+    font->cell_h = BUMI_FONT_GLYPH_H * scale + 2 * BUMI_GLYPH_BORDER;
+    font->scratch = (uint32_t*) BUMI_internal_malloc((size_t) font->cell_w * font->cell_h * 4);
+    if (!font->scratch) {
+        BUMI_internal_free(font);
+        set_error("Failed to allocate font");
+        return NULL;
+    }
+
+    font->texture = BUMI_TextureCreate(renderer, BUMI_PIXELFORMAT_BGRA32, BUMI_TEXTUREACCESS_STATIC,
+                                       font->cell_w * BUMI_GLYPH_CACHE_COLS, font->cell_h * BUMI_GLYPH_CACHE_ROWS);
+    if (!font->texture) {
+        BUMI_internal_free(font->scratch);
+        BUMI_internal_free(font);
+        return NULL;
+    }
+
+    for (int i = 0; i < BUMI_GLYPH_HASH_SIZE; i++) {
+        font->buckets[i] = -1;
+    }
+    font->lru_head = font->lru_tail = -1;
+    for (int i = 0; i < BUMI_GLYPH_CACHE_CELLS; i++) {
+        font->cells[i].hash_next = -1;
+        glyph_lru_push_front(font, i);
+    }
+    return font;
+}
+
+void BUMI_FontDestroy(BUMI_Font* font) {
+    if (!font) return;
+
+    BUMI_ClearError();
+    BUMI_TextureDestroy(font->texture);
+    BUMI_internal_free(font->scratch);
+    BUMI_internal_free(font);
+}
+
+int BUMI_FontGetCacheStats(const BUMI_Font* font, uint64_t* hits, uint64_t* misses) {
+    BUMI_ClearError();
+
+    if (!font) {
+        set_error("Invalid font");
+        return -1;
+    }
+    if (hits) *hits = font->hits;
+    if (misses) *misses = font->misses;
+    return 0;
+}
+
+// Next codepoint of a UTF-8 string; malformed bytes decode as U+FFFD
+static uint32_t utf8_next(const unsigned char** text) {
+    const unsigned char* p = *text;
+    uint32_t c = *p++;
+    int extra = c >= 0xF0 && c < 0xF8 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    if (c >= 0x80 && extra == 0) {
+        *text = p;
+        return 0xFFFD;
+    }
+    if (extra) {
+        c &= 0x3F >> extra;
+        for (int i = 0; i < extra; i++, p++) {
+            if ((*p & 0xC0) != 0x80) {
+                *text = p;
+                return 0xFFFD;
+            }
+            c = (c << 6) | (*p & 0x3F);
+        }
+    }
+    *text = p;
+    return c;
+}
+
+int BUMI_TextSize(const BUMI_Font* font, const char* text, int* w, int* h) {
+    BUMI_ClearError();
+
+    if (!font || !text) {
+        set_error("Invalid font or text for measuring");
+        return -1;
+    }
+
+    int columns = 0, widest = 0, lines = 1;
+    const unsigned char* p = (const unsigned char*) text;
+    while (*p) {
+        if (utf8_next(&p) == '\n') {
+            lines++;
+            columns = 0;
+        } else if (++columns > widest) {
+            widest = columns;
+        }
+    }
+    if (w) *w = widest ? (widest * BUMI_FONT_ADVANCE - 1) * font->scale : 0;
+    if (h) *h = ((lines - 1) * BUMI_FONT_LINE + BUMI_FONT_GLYPH_H) * font->scale;
+    return 0;
+}
+
+int BUMI_RenderText(BUMI_Renderer* renderer, BUMI_Font* font, const char* text, int x, int y) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for text drawing");
+        return -1;
+    }
+    if (!font || font->renderer->driver != renderer->driver) {
+        set_error("Font was created on a different render driver");
+        return -1;
+    }
+    if (!text) {
+        set_error("Invalid text for drawing");
+        return -1;
+    }
+
+    uint8_t color[4];
+    draw_color_bytes(renderer, color);
+    BUMI_Rect srcs[BUMI_TEXT_BATCH];
+    BUMI_Rect dsts[BUMI_TEXT_BATCH];
+    int count = 0;
+    int pen_x = x, pen_y = y;
+    font->serial++;
+
+    const unsigned char* p = (const unsigned char*) text;
+    while (*p) {
+        uint32_t codepoint = utf8_next(&p);
+        if (codepoint == '\n') {
+            pen_x = x;
+            pen_y += BUMI_FONT_LINE * font->scale;
+            continue;
+        }
+        if (codepoint == ' ') {
+            pen_x += BUMI_FONT_ADVANCE * font->scale;
+            continue;
+        }
+
+        int cell = glyph_find(font, codepoint);
+        if (cell >= 0) {
+            font->hits++;
+        } else {
+            font->misses++;
+            cell = font->lru_tail;
+            BUMI_GlyphCell* victim = &font->cells[cell];
+            // Quads already queued by this call still point at the cell
+            if (victim->valid && victim->serial == font->serial && count > 0) {
+                if (renderer->driver->copy_batch(renderer, font->texture, srcs, dsts, count, color) != 0) {
+                    return -1;
+                }
+                count = 0;
+            }
+            if (victim->valid) {
+                glyph_unhash(font, cell);
+            }
+            victim->valid = false;
+            if (glyph_load(font, cell, codepoint) != 0) {
+                return -1;
+            }
+            victim->codepoint = codepoint;
+            victim->valid = true;
+            victim->hash_next = font->buckets[codepoint % BUMI_GLYPH_HASH_SIZE];
+            font->buckets[codepoint % BUMI_GLYPH_HASH_SIZE] = cell;
+        }
+        font->cells[cell].serial = font->serial;
+        glyph_lru_unlink(font, cell);
+        glyph_lru_push_front(font, cell);
+
+        glyph_cell_rect(font, cell, &srcs[count]);
+        dsts[count].x = pen_x;
+        dsts[count].y = pen_y;
+        dsts[count].w = srcs[count].w;
+        dsts[count].h = srcs[count].h;
+        pen_x += BUMI_FONT_ADVANCE * font->scale;
+        if (++count == BUMI_TEXT_BATCH) {
+            if (renderer->driver->copy_batch(renderer, font->texture, srcs, dsts, count, color) != 0) {
+                return -1;
+            }
+            count = 0;
+        }
+    }
+
+    if (count > 0) {
+        return renderer->driver->copy_batch(renderer, font->texture, srcs, dsts, count, color);
+    }
+    return 0;
+}
+
+// Command buffers record into a flat byte stream of 4-byte headers
+// (type in the low 8 bits, payload count in the upper 24) followed by the
+// payload. Recording touches nothing but the buffer itself, so any thread
+// may record while another owns the GL context.
+enum {
+    BUMI_CMD_SETDRAWCOLOR = 1, // payload: 4 bytes RGBA
+    BUMI_CMD_CLEAR,
+    BUMI_CMD_FILLRECTS,        // payload: count BUMI_Rects
+    BUMI_CMD_FILLTARGET,       // fill the whole output (NULL rect)
+    BUMI_CMD_PRESENT
+};
+
+#define BUMI_CMD_MAX_COUNT 0x00FFFFFFu
+
+struct BUMI_CommandBuffer {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    size_t last;     // Offset of the most recent command header
+    bool has_last;
+};
+
+static uint32_t cmd_header(uint32_t type, uint32_t count) {
+    return type | (count << 8);
+}
+
+static uint8_t* cmd_reserve(BUMI_CommandBuffer* buffer, size_t bytes) {
+    if (buffer->size + bytes > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while (capacity < buffer->size + bytes) {
+            capacity *= 2;
+        }
+        uint8_t* data = (uint8_t*) BUMI_internal_realloc(buffer->data, capacity);
+        if (!data) {
+            set_error("Failed to grow command buffer");
+            return NULL;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+
+    uint8_t* out = buffer->data + buffer->size;
+    buffer->size += bytes;
+    return out;
+}
+
+static int cmd_push(BUMI_CommandBuffer* buffer, uint32_t type, const void* payload, size_t payload_size, uint32_t count) {
+    size_t offset = buffer->size;
+    uint8_t* out = cmd_reserve(buffer, sizeof(uint32_t) + payload_size);
+    if (!out) {
+        return -1;
+    }
+
+    uint32_t header = cmd_header(type, count);
+    memcpy(out, &header, sizeof(header));
+    if (payload_size) {
+        memcpy(out + sizeof(header), payload, payload_size);
+    }
+    buffer->last = offset;
+    buffer->has_last = true;
+    return 0;
+}
+
+BUMI_CommandBuffer* BUMI_CommandBufferCreate(void) {
+    BUMI_CommandBuffer* buffer = (BUMI_CommandBuffer*) BUMI_internal_calloc(1, sizeof(BUMI_CommandBuffer));
+    if (!buffer) {
+        set_error("Failed to allocate command buffer");
+        return NULL;
+    }
+    return buffer;
+}
+
+void BUMI_CommandBufferDestroy(BUMI_CommandBuffer* buffer) {
+    if (!buffer) return;
+
+    BUMI_internal_free(buffer->data);
+    BUMI_internal_free(buffer);
+}
+
+void BUMI_CommandBufferReset(BUMI_CommandBuffer* buffer) {
+    if (!buffer) return;
+
+    buffer->size = 0;
+    buffer->has_last = false;
+}
+
+int BUMI_CmdSetDrawColor(BUMI_CommandBuffer* buffer, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    if (!buffer) {
+        set_error("Invalid command buffer");
+        return -1;
+    }
+
+    uint8_t color[4] = {r, g, b, a};
+
+    // Back-to-back color changes only need the last one
+    if (buffer->has_last) {
+        uint32_t header;
+        memcpy(&header, buffer->data + buffer->last, sizeof(header));
+        if ((header & 0xFF) == BUMI_CMD_SETDRAWCOLOR) {
+            memcpy(buffer->data + buffer->last + sizeof(header), color, sizeof(color));
+            return 0;
+        }
+    }
+    return cmd_push(buffer, BUMI_CMD_SETDRAWCOLOR, color, sizeof(color), 0);
+}
+
+int BUMI_CmdClear(BUMI_CommandBuffer* buffer) {
+    if (!buffer) {
+        set_error("Invalid command buffer");
+        return -1;
+    }
+    return cmd_push(buffer, BUMI_CMD_CLEAR, NULL, 0, 0);
+}
+
+int BUMI_CmdFillRect(BUMI_CommandBuffer* buffer, const BUMI_Rect* rect) {
+    if (!buffer) {
+        set_error("Invalid command buffer");
+        return -1;
+    }
+    if (!rect) {
+        return cmd_push(buffer, BUMI_CMD_FILLTARGET, NULL, 0, 0);
+    }
+    return BUMI_CmdFillRects(buffer, rect, 1);
+}
+
+int BUMI_CmdFillRects(BUMI_CommandBuffer* buffer, const BUMI_Rect* rects, int count) {
+    if (!buffer) {
+        set_error("Invalid command buffer");
+        return -1;
+    }
+    if (!rects || count < 0) {
+        set_error("Invalid rectangles for command buffer");
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // Extend the previous fill when it is the last command in the stream
+    if (buffer->has_last) {
+        uint32_t header;
+        memcpy(&header, buffer->data + buffer->last, sizeof(header));
+        uint32_t previous = header >> 8;
+        if ((header & 0xFF) == BUMI_CMD_FILLRECTS && previous + (uint32_t) count <= BUMI_CMD_MAX_COUNT) {
+            size_t last = buffer->last;
+            uint8_t* out = cmd_reserve(buffer, count * sizeof(BUMI_Rect));
+            if (!out) {
+                return -1;
+            }
+            memcpy(out, rects, count * sizeof(BUMI_Rect));
+            header = cmd_header(BUMI_CMD_FILLRECTS, previous + (uint32_t) count);
+            memcpy(buffer->data + last, &header, sizeof(header));
+            return 0;
+        }
+    }
+
+    while (count > 0) {
+        uint32_t chunk = (uint32_t) count > BUMI_CMD_MAX_COUNT ? BUMI_CMD_MAX_COUNT : (uint32_t) count;
+        if (cmd_push(buffer, BUMI_CMD_FILLRECTS, rects, chunk * sizeof(BUMI_Rect), chunk) != 0) {
+            return -1;
+        }
+        rects += chunk;
+        count -= (int) chunk;
+    }
+    return 0;
+}
+
+int BUMI_CmdPresent(BUMI_CommandBuffer* buffer) {
+    if (!buffer) {
+        set_error("Invalid command buffer");
+        return -1;
+    }
+    return cmd_push(buffer, BUMI_CMD_PRESENT, NULL, 0, 0);
+}
+
+static size_t cmd_size(uint32_t header) {
+    switch (header & 0xFF) {
+        case BUMI_CMD_SETDRAWCOLOR: return sizeof(uint32_t) + 4;
+        case BUMI_CMD_FILLRECTS: return sizeof(uint32_t) + (header >> 8) * sizeof(BUMI_Rect);
+        default: return sizeof(uint32_t);
+    }
+}
+
+// Offset of the last clear before the next present, or `offset` if there is none
+static size_t cmd_find_last_clear(const BUMI_CommandBuffer* buffer, size_t offset) {
+    size_t last_clear = offset;
+    while (offset < buffer->size) {
+        uint32_t header;
+        memcpy(&header, buffer->data + offset, sizeof(header));
+        if ((header & 0xFF) == BUMI_CMD_PRESENT) {
+            break;
+        }
+        if ((header & 0xFF) == BUMI_CMD_CLEAR) {
+            last_clear = offset;
+        }
+        offset += cmd_size(header);
+    }
+    return last_clear;
+}
+
+int BUMI_SubmitCommandBuffer(BUMI_Renderer* renderer, const BUMI_CommandBuffer* buffer) {
+    BUMI_ClearError();
+
+    if (!renderer_valid(renderer)) {
+        set_error("Invalid renderer for command buffer submission");
+        return -1;
+    }
+    if (!buffer) {
+        set_error("Invalid command buffer");
+        return -1;
+    }
+
+    // Fills are never reordered (they may overlap), but every fill or clear
+    // that a later clear in the same frame overwrites is skipped entirely
+    size_t frame_clear = cmd_find_last_clear(buffer, 0);
+    size_t offset = 0;
+    int result = 0;
+    while (offset < buffer->size && result == 0) {
+        uint32_t header;
+        memcpy(&header, buffer->data + offset, sizeof(header));
+        const uint8_t* payload = buffer->data + offset + sizeof(header);
+        bool dead = offset < frame_clear;
+
+        switch (header & 0xFF) {
+            case BUMI_CMD_SETDRAWCOLOR:
+                result = BUMI_SetRenderDrawColor(renderer, payload[0], payload[1], payload[2], payload[3]);
+                break;
+            case BUMI_CMD_CLEAR:
+                if (!dead) {
+                    result = BUMI_RenderClear(renderer);
+                }
+                break;
+            case BUMI_CMD_FILLRECTS:
+                if (!dead) {
+                    result = BUMI_RenderFillRects(renderer, (const BUMI_Rect*) payload, (int)(header >> 8));
+                }
+                break;
+            case BUMI_CMD_FILLTARGET:
+                if (!dead) {
+                    result = BUMI_RenderFillRect(renderer, NULL);
+                }
+                break;
+            case BUMI_CMD_PRESENT:
+                BUMI_RenderPresent(renderer);
+                frame_clear = cmd_find_last_clear(buffer, offset + sizeof(header));
+                break;
+            default:
+                set_error("Corrupt command buffer");
+                return -1;
+        }
+        offset += cmd_size(header);
+    }
+    return result;
+}
+
+void BUMI_Delay(uint32_t ms) {
+    usleep(ms * 1000);
+}
+
+// === FRAME PACING ===
+
+// Sleep until this close to the deadline, then spin the rest of the way;
+// the scheduler routinely wakes sleepers a few hundred microseconds late
+#define BUMI_PACER_SPIN_NS 1000000LL
+#define BUMI_DEFAULT_REFRESH_RATE 60.0
+
+struct BUMI_FramePacer {
+    int64_t period_ns;
+    int64_t deadline_ns; // Absolute CLOCK_MONOTONIC time the next frame is due
+};
+
+// XRandR is loaded at runtime so the library does not link against it.
+// Only the opaque screen-configuration calls are needed
+typedef void* (*BUMI_XRRGetScreenInfo)(Display*, Window);
+typedef short (*BUMI_XRRConfigCurrentRate)(void*);
+typedef void (*BUMI_XRRFreeScreenConfigInfo)(void*);
+
+static double xrandr_refresh_rate(void) {
+    void* lib = dlopen("libXrandr.so.2", RTLD_LAZY | RTLD_LOCAL);
+    if (!lib) {
+        return 0.0;
+    }
+
+    double rate = 0.0;
+    BUMI_XRRGetScreenInfo get_info = (BUMI_XRRGetScreenInfo) dlsym(lib, "XRRGetScreenInfo");
+    BUMI_XRRConfigCurrentRate current_rate = (BUMI_XRRConfigCurrentRate) dlsym(lib, "XRRConfigCurrentRate");
+    BUMI_XRRFreeScreenConfigInfo free_info = (BUMI_XRRFreeScreenConfigInfo) dlsym(lib, "XRRFreeScreenConfigInfo");
+    if (get_info && current_rate && free_info) {
+        void* config = get_info(ctx->dpy, ctx->root);
+        if (config) {
+            rate = current_rate(config);
+            free_info(config);
+        }
+    }
+    dlclose(lib);
+    return rate;
+}
+
+double BUMI_GetRefreshRate(BUMI_Window* window) {
+    BUMI_ClearError();
+
+    if (!ctx) {
+        set_error("Refresh rate query requires an initialized context");
+        return 0.0;
+    }
+
+    double rate = xrandr_refresh_rate();
+    if (rate > 0.0) {
+        return rate;
+    }
+
+    // GLX_OML_sync_control reports the exact rate of the window's output
+    BUMI_Renderer* renderer = window ? window->renderers : NULL;
+    if (renderer && (renderer->driver->flags & BUMI_RENDERER_ACCELERATED) && gl.loaded) {
+        PFNGLXGETMSCRATEOMLPROC get_msc_rate = (PFNGLXGETMSCRATEOMLPROC) gl_get_proc("glXGetMscRateOML");
+        int32_t numerator = 0, denominator = 0;
+        if (gl.GetSyncValuesOML && get_msc_rate &&
+            get_msc_rate(ctx->dpy, (Window)(uintptr_t)window->backend_data, &numerator, &denominator) &&
+            numerator > 0 && denominator > 0) {
+            return (double) numerator / denominator;
+        }
+    }
+    return BUMI_DEFAULT_REFRESH_RATE;
+}
+
+BUMI_FramePacer* BUMI_FramePacerCreate(BUMI_Window* window, double hz) {
+    BUMI_ClearError();
+
+    if (hz <= 0.0) {
+        hz = BUMI_GetRefreshRate(window);
+        if (hz <= 0.0) {
+            hz = BUMI_DEFAULT_REFRESH_RATE;
+        }
+    }
+
+    BUMI_FramePacer* pacer = (BUMI_FramePacer*) BUMI_internal_malloc(sizeof(BUMI_FramePacer));
+    if (!pacer) {
+        set_error("Failed to allocate frame pacer");
+        return NULL;
+    }
+    pacer->period_ns = (int64_t)(1e9 / hz);
+    pacer->deadline_ns = monotonic_ns() + pacer->period_ns;
+    return pacer;
+}
+
+void BUMI_FramePacerDestroy(BUMI_FramePacer* pacer) {
+    BUMI_internal_free(pacer);
+}
+
+void BUMI_FramePacerWait(BUMI_FramePacer* pacer) {
+    if (!pacer) return;
+
+    int64_t now = monotonic_ns();
+    if (now - pacer->deadline_ns > pacer->period_ns) {
+        // More than a frame late: start over instead of bursting to catch up
+        pacer->deadline_ns = now + pacer->period_ns;
+        return;
+    }
+
+    int64_t wake = pacer->deadline_ns - BUMI_PACER_SPIN_NS;
+    if (wake > now) {
+        struct timespec ts;
+        ts.tv_sec = (time_t)(wake / 1000000000LL);
+        ts.tv_nsec = (long)(wake % 1000000000LL);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+    }
+    while (monotonic_ns() < pacer->deadline_ns) {
+    }
+
+    // Deadlines advance on a fixed grid, so wake-up jitter does not accumulate
+    pacer->deadline_ns += pacer->period_ns;
+}
+
+static BUMI_Keycode x11_to_bumi_keycode(KeySym keysym) {
+    switch (keysym) {
         case XK_a: return BUMI_KEY_A;
         case XK_b: return BUMI_KEY_B;
         case XK_c: return BUMI_KEY_C;
@@ -437,128 +5124,808 @@ static BUMI_Keycode x11_to_bumi_keycode(KeySym keysym) {
     }
 }
 
-int BUMI_PollEvent(BUMI_Event* event) {
+// One XGetKeyboardMapping round trip instead of a keysym lookup per event.
+// Column 0 is the unshifted keysym, as BUMI_Keycode expects
+static void keymap_build(void) {
+    int min_keycode, max_keycode, per_keycode;
+    XDisplayKeycodes(ctx->input_dpy, &min_keycode, &max_keycode);
+    KeySym* keysyms = XGetKeyboardMapping(ctx->input_dpy, (KeyCode) min_keycode, max_keycode - min_keycode + 1,
+                                          &per_keycode);
+
+    memset(ctx->keymap, 0, sizeof(ctx->keymap));
+    for (int keycode = min_keycode; keysyms && keycode <= max_keycode && keycode < 256; keycode++) {
+        ctx->keymap[keycode] = x11_to_bumi_keycode(keysyms[(keycode - min_keycode) * per_keycode]);
+    }
+    if (keysyms) {
+        XFree(keysyms);
+    }
+    ctx->keymap_loaded = true;
+}
+
+// Map an X server time onto the monotonic clock. The server stamps an event
+// before we can read it, so the smallest capture - server difference seen
+// is the best estimate of the offset between the clocks; a jump of more
+// than a second means the server time wrapped or the clocks drifted
+static void event_stamp(BUMI_Event* event, Time time) {
+    int64_t server_ns = (int64_t)(uint32_t) time * 1000000LL;
+    int64_t offset = (int64_t) event->common.capture_ns - server_ns;
+    if (!ctx->server_time_synced || offset < ctx->server_time_offset ||
+        offset - ctx->server_time_offset > 1000000000LL) {
+        ctx->server_time_offset = offset;
+        ctx->server_time_synced = true;
+    }
+    event->common.timestamp = (uint64_t)(server_ns + ctx->server_time_offset);
+}
+
+// Atomic so the app can read the bitset while the input thread writes it
+static void key_state_set(BUMI_Keycode key, bool down) {
+    if (key == BUMI_KEY_UNKNOWN) {
+        return;
+    }
+    int index = BUMI_KEY_INDEX(key);
+    uint32_t bit = 1u << (index & 31);
+    if (down) {
+        __atomic_fetch_or(&ctx->key_state[index >> 5], bit, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_and(&ctx->key_state[index >> 5], ~bit, __ATOMIC_RELAXED);
+    }
+}
+
+const uint32_t* BUMI_GetKeyboardState(int* numkeys) {
     BUMI_ClearError();
 
-    if (!ctx || !event) {
-        set_error("Event polling requires initialized context and valid event pointer");
-        return 0;
+    if (!ctx) {
+        set_error("Keyboard state requires initialized context");
+        return NULL;
     }
+    if (numkeys) {
+        *numkeys = BUMI_NUM_KEY_INDICES;
+    }
+    return ctx->key_state;
+}
 
-    if (!XPending(ctx->dpy)) {
-        return 0;
+#if BUMI_HAVE_XI2
+typedef Status (*BUMI_XIQueryVersion)(Display*, int*, int*);
+typedef int (*BUMI_XISelectEvents)(Display*, Window, XIEventMask*, int);
+
+// Raw motion (XInput 2.0) reports unaccelerated deltas at the device's
+// full rate. It is selected on the root window for every master pointer
+static void xi2_init(void) {
+    int event, error;
+    if (!XQueryExtension(ctx->input_dpy, "XInputExtension", &ctx->xi_opcode, &event, &error)) {
+        return;
+    }
+    ctx->xi_lib = dlopen("libXi.so.6", RTLD_LAZY | RTLD_LOCAL);
+    if (!ctx->xi_lib) {
+        return;
+    }
+
+    BUMI_XIQueryVersion query_version = (BUMI_XIQueryVersion) dlsym(ctx->xi_lib, "XIQueryVersion");
+    BUMI_XISelectEvents select_events = (BUMI_XISelectEvents) dlsym(ctx->xi_lib, "XISelectEvents");
+    int major = 2, minor = 0;
+    if (!query_version || !select_events || query_version(ctx->input_dpy, &major, &minor) != Success || major < 2) {
+        return;
+    }
+
+    unsigned char bits[XIMaskLen(XI_RawMotion)];
+    memset(bits, 0, sizeof(bits));
+    XISetMask(bits, XI_RawMotion);
+    XIEventMask mask;
+    mask.deviceid = XIAllMasterDevices;
+    mask.mask_len = (int) sizeof(bits);
+    mask.mask = bits;
+    ctx->xi_raw = select_events(ctx->input_dpy, ctx->root, &mask, 1) == Success;
+}
+
+// Raw motion is not tied to a window; it goes to the one under the pointer
+static bool translate_raw_motion(XGenericEventCookie* cookie, BUMI_Event* event) {
+    if (!ctx->xi_raw || cookie->extension != ctx->xi_opcode || cookie->evtype != XI_RawMotion ||
+        !XGetEventData(ctx->input_dpy, cookie)) {
+        return false;
+    }
+
+    const XIRawEvent* raw = (const XIRawEvent*) cookie->data;
+    double delta[2] = {0.0, 0.0};
+    const double* value = raw->raw_values;
+    for (int axis = 0; axis < raw->valuators.mask_len * 8; axis++) {
+        if (XIMaskIsSet(raw->valuators.mask, axis)) {
+            if (axis < 2) {
+                delta[axis] = *value;
+            }
+            value++;
+        }
+    }
+    Time time = raw->time;
+    XFreeEventData(ctx->input_dpy, cookie);
+
+    if (!ctx->mouse_window || (delta[0] == 0.0 && delta[1] == 0.0)) {
+        return false;
+    }
+    event->type = BUMI_MOUSEMOTION;
+    event_stamp(event, time);
+    event->motion.windowID = ctx->mouse_window;
+    event->motion.state = ctx->mouse_state;
+    event->motion.x = ctx->mouse_x;
+    event->motion.y = ctx->mouse_y;
+    event->motion.xrel = (float) delta[0];
+    event->motion.yrel = (float) delta[1];
+    return true;
+}
+#endif
+
+// Keymap and XInput2 setup, done by whichever thread translates input
+static void input_prepare(void) {
+    if (!ctx->keymap_loaded) {
+        keymap_build();
+    }
+    if (!ctx->input_ready) {
+#if BUMI_HAVE_XI2
+        xi2_init();
+#endif
+        ctx->input_ready = true;
+    }
+}
+
+int BUMI_SetMouseFullResolution(bool enabled) {
+    BUMI_ClearError();
+
+    if (!ctx) {
+        set_error("Mouse settings require initialized context");
+        return -1;
+    }
+    ctx->mouse_full_resolution = enabled;
+    return 0;
+}
+
+// X buttons 4-7 are wheel notches; 8 and 9 are the side buttons
+static uint8_t x11_to_bumi_button(unsigned int button) {
+    switch (button) {
+        case Button1: return BUMI_BUTTON_LEFT;
+        case Button2: return BUMI_BUTTON_MIDDLE;
+        case Button3: return BUMI_BUTTON_RIGHT;
+        case 8: return BUMI_BUTTON_X1;
+        case 9: return BUMI_BUTTON_X2;
+        default: return 0;
+    }
+}
+
+static bool translate_button(const XButtonEvent* xbutton, BUMI_WindowID window, BUMI_Event* event) {
+    if (xbutton->button >= Button4 && xbutton->button <= 7) {
+        if (xbutton->type != ButtonPress) {
+            return false;
+        }
+        static const int dx[4] = {0, 0, -1, 1};
+        static const int dy[4] = {1, -1, 0, 0};
+        event->type = BUMI_MOUSEWHEEL;
+        event->wheel.x = dx[xbutton->button - Button4];
+        event->wheel.y = dy[xbutton->button - Button4];
+        return true;
     }
 
-    XEvent xevent;
-    XNextEvent(ctx->dpy, &xevent);
+    uint8_t button = x11_to_bumi_button(xbutton->button);
+    if (!button) {
+        return false;
+    }
+    if (xbutton->type == ButtonPress) {
+        ctx->mouse_state |= BUMI_BUTTON_MASK(button);
+    } else {
+        ctx->mouse_state &= ~BUMI_BUTTON_MASK(button);
+    }
+    event->type = xbutton->type == ButtonPress ? BUMI_MOUSEBUTTONDOWN : BUMI_MOUSEBUTTONUP;
+    event->button.button = button;
+    event->button.x = xbutton->x;
+    event->button.y = xbutton->y;
+    ctx->mouse_window = window;
+    ctx->mouse_x = xbutton->x;
+    ctx->mouse_y = xbutton->y;
+    return true;
+}
 
+static void event_init(BUMI_Event* event, BUMI_WindowID window) {
     memset(event, 0, sizeof(BUMI_Event));
-    event->key.timestamp = (uint32_t)(time(NULL) * 1000);
-    event->key.windowID = (BUMI_WindowID)(uintptr_t)xevent.xany.window;
+    event->common.capture_ns = (uint64_t) monotonic_ns();
+    event->common.timestamp = event->common.capture_ns;
+    event->common.windowID = window;
+}
+
+// Keyboard and pointer events, read from ctx->input_dpy. `window` is the
+// ID of the window the event was reported for, 0 if it is not ours
+static bool translate_input(XEvent* xevent, BUMI_WindowID window, BUMI_Event* event) {
+    switch (xevent->type) {
+#if BUMI_HAVE_XI2
+        case GenericEvent:
+            return translate_raw_motion(&xevent->xcookie, event);
+#endif
+        case MotionNotify:
+            if (!window) {
+                return false;
+            }
+            // With raw motion the events come from XI_RawMotion, unaccelerated;
+            // core motion only keeps the pointer position they report current
+            if (ctx->xi_raw) {
+                ctx->mouse_window = window;
+                ctx->mouse_x = xevent->xmotion.x;
+                ctx->mouse_y = xevent->xmotion.y;
+                return false;
+            }
+            event->type = BUMI_MOUSEMOTION;
+            event_stamp(event, xevent->xmotion.time);
+            event->motion.state = ctx->mouse_state;
+            event->motion.x = xevent->xmotion.x;
+            event->motion.y = xevent->xmotion.y;
+            if (ctx->mouse_window == window) {
+                event->motion.xrel = (float)(xevent->xmotion.x - ctx->mouse_x);
+                event->motion.yrel = (float)(xevent->xmotion.y - ctx->mouse_y);
+            }
+            ctx->mouse_window = window;
+            ctx->mouse_x = xevent->xmotion.x;
+            ctx->mouse_y = xevent->xmotion.y;
+            return true;
+        case ButtonPress:
+        case ButtonRelease:
+            if (!window) {
+                return false;
+            }
+            event_stamp(event, xevent->xbutton.time);
+            return translate_button(&xevent->xbutton, window, event);
+        case EnterNotify:
+            if (window) {
+                ctx->mouse_window = window;
+                ctx->mouse_x = xevent->xcrossing.x;
+                ctx->mouse_y = xevent->xcrossing.y;
+            }
+            return false;
+        case LeaveNotify:
+            if (window && ctx->mouse_window == window) {
+                ctx->mouse_window = 0;
+            }
+            return false;
+        case KeyPress:
+        case KeyRelease:
+            event->type = xevent->type == KeyPress ? BUMI_KEYDOWN : BUMI_KEYUP;
+            event_stamp(event, xevent->xkey.time);
+            event->key.keycode = ctx->keymap[xevent->xkey.keycode & 0xFF];
+            key_state_set(event->key.keycode, xevent->type == KeyPress);
+            return true;
+        case MappingNotify:
+            XRefreshKeyboardMapping(&xevent->xmapping);
+            if (xevent->xmapping.request == MappingKeyboard) {
+                keymap_build();
+            }
+            return false;
+        case FocusOut:
+            // Releases sent while another window (or a grab) has focus never reach us
+            for (int i = 0; i < BUMI_NUM_KEY_INDICES / 32; i++) {
+                __atomic_store_n(&ctx->key_state[i], 0u, __ATOMIC_RELAXED);
+            }
+            return false;
+        default:
+            return false;
+    }
+}
 
-    BUMI_Window* window = find_window(xevent.xany.window);
+// Expose is answered here from the retained frame (or a redraw when there
+// is none); the app still hears about it once the series ends
+static void handle_expose(BUMI_Window* window, const XExposeEvent* expose) {
+    if (window->renderers) {
+        BUMI_Renderer* renderer = window->renderers;
+        BUMI_Rect area = {expose->x, expose->y, expose->width, expose->height};
+        if (renderer->driver->repaint(renderer, &area) != 0) {
+            BUMI_RenderClear(renderer);
+            BUMI_RenderFillRect(renderer, NULL);
+            BUMI_RenderPresent(renderer);
+        }
+    } else if (window->flags & BUMI_WINDOW_CLEAR) {
+        GC gc = XCreateGC(ctx->dpy, expose->window, 0, NULL);
+        XSetForeground(ctx->dpy, gc, BlackPixel(ctx->dpy, ctx->screen));
+        XFillRectangle(ctx->dpy, expose->window, gc, 0, 0, window->w, window->h);
+        XFreeGC(ctx->dpy, gc);
+        XFlush(ctx->dpy);
+    }
+}
 
-    if (xevent.type == ClientMessage && xevent.xclient.data.l[0] == ctx->wm_delete) {
-        event->type = BUMI_WINDOWEVENT;
-        event->window.window_event = BUMI_WINDOWEVENT_CLOSE;
-        return 1;
-    } else if (xevent.type == KeyPress) {
-        event->type = BUMI_KEYDOWN;
-        event->key.keycode = x11_to_bumi_keycode(XKeycodeToKeysym(ctx->dpy, xevent.xkey.keycode, 0));
-        return 1;
-    } else if (xevent.type == KeyRelease) {
-        event->type = BUMI_KEYUP;
-        event->key.keycode = x11_to_bumi_keycode(XKeycodeToKeysym(ctx->dpy, xevent.xkey.keycode, 0));
-        return 1;
-    } else if (xevent.type == ConfigureNotify) {
-        if (window) {
-            window->w = xevent.xconfigure.width;
-            window->h = xevent.xconfigure.height;
-            window->x = xevent.xconfigure.x;
-            window->y = xevent.xconfigure.y;
+// Translate one event from the main connection; returns false for events
+// that have no BUMI_Event
+static bool translate_event(XEvent* xevent, BUMI_Event* event) {
+    BUMI_Window* window = find_window(xevent->xany.window);
+    event_init(event, window ? window->id : 0);
+
+    switch (xevent->type) {
+        case ClientMessage:
+            if ((Atom) xevent->xclient.data.l[0] != ctx->atoms[BUMI_ATOM_WM_DELETE_WINDOW]) {
+                return false;
+            }
+            event->type = BUMI_WINDOWEVENT;
+            event->window.window_event = BUMI_WINDOWEVENT_CLOSE;
+            return true;
+        case ConfigureNotify: {
+            if (!window) {
+                return false;
+            }
+            bool resized = window->w != xevent->xconfigure.width || window->h != xevent->xconfigure.height;
+            window->w = xevent->xconfigure.width;
+            window->h = xevent->xconfigure.height;
+            window->x = xevent->xconfigure.x;
+            window->y = xevent->xconfigure.y;
+            if (!resized) {
+                return false;
+            }
             event->type = BUMI_WINDOWEVENT;
             event->window.window_event = BUMI_WINDOWEVENT_RESIZED;
-            return 1;
+            event->window.data1 = window->w;
+            event->window.data2 = window->h;
+            return true;
         }
-        return 0;
-    } else if (xevent.type == Expose) {
-        if (window) {
-            if (window->renderers) {
-                BUMI_Renderer* renderer = window->renderers;
-                BUMI_RenderClear(renderer);
-                BUMI_RenderFillRect(renderer, NULL);
-                BUMI_RenderPresent(renderer);
-            } else if (window->flags & BUMI_WINDOW_CLEAR) {
-                GC gc = XCreateGC(ctx->dpy, xevent.xexpose.window, 0, NULL);
-                XSetForeground(ctx->dpy, gc, BlackPixel(ctx->dpy, ctx->screen));
-                XFillRectangle(ctx->dpy, xevent.xexpose.window, gc, 0, 0, window->w, window->h);
-                XFreeGC(ctx->dpy, gc);
-                XFlush(ctx->dpy);
+        case Expose:
+            if (!window) {
+                return false;
+            }
+            handle_expose(window, &xevent->xexpose);
+            if (xevent->xexpose.count > 0) {
+                return false;
+            }
+            event->type = BUMI_WINDOWEVENT;
+            event->window.window_event = BUMI_WINDOWEVENT_EXPOSED;
+            return true;
+        default:
+            // The input thread owns keyboard and pointer translation when it
+            // runs; it gets its own copy of MappingNotify, which every
+            // connection receives
+            return !ctx->input_threaded && translate_input(xevent, window ? window->id : 0, event);
+    }
+}
+
+static BUMI_Event* event_at(int index) {
+    return &ctx->event_ring[(ctx->event_head + index) & (BUMI_EVENT_RING_SIZE - 1)];
+}
+
+// Window state and pointer motion only matter in their latest form, so a
+// newer event replaces the newest queued one when it is for the same
+// window; motion deltas add up instead of being lost
+static bool event_coalesces(const BUMI_Event* a, const BUMI_Event* b) {
+    if (a->type == BUMI_MOUSEMOTION && b->type == BUMI_MOUSEMOTION) {
+        return !ctx->mouse_full_resolution && a->motion.windowID == b->motion.windowID;
+    }
+    if (a->type != BUMI_WINDOWEVENT || b->type != BUMI_WINDOWEVENT || a->window.windowID != b->window.windowID) {
+        return false;
+    }
+    uint8_t kind = a->window.window_event;
+    return kind == b->window.window_event && (kind == BUMI_WINDOWEVENT_RESIZED || kind == BUMI_WINDOWEVENT_EXPOSED);
+}
+
+static bool event_push(const BUMI_Event* event) {
+    // Only the newest one, so nothing moves past a key or button event
+    if (ctx->event_count > 0) {
+        BUMI_Event* last = event_at(ctx->event_count - 1);
+        if (event_coalesces(last, event)) {
+            float xrel = last->motion.xrel;
+            float yrel = last->motion.yrel;
+            *last = *event;
+            if (event->type == BUMI_MOUSEMOTION) {
+                last->motion.xrel += xrel;
+                last->motion.yrel += yrel;
             }
+            return true;
+        }
+    }
+    if (ctx->event_count == BUMI_EVENT_RING_SIZE) {
+        return false;
+    }
+    *event_at(ctx->event_count++) = *event;
+    return true;
+}
+
+// === USER EVENTS ===
+
+// Wake a BUMI_WaitEvent sleeping on the main thread. Only the first event
+// after a pump writes the eventfd; the pump clears the flag before it looks
+// at the queues, so an event queued after that always writes again
+static void wake_main(void) {
+    if (!__atomic_exchange_n(&ctx->wake_pending, true, __ATOMIC_SEQ_CST)) {
+        uint64_t one = 1;
+        if (write(ctx->wake_fd, &one, sizeof(one)) < 0) {
+            // The counter only saturates if nobody has read it for ages
+        }
+    }
+}
+
+// The read is unconditional: a producer can set the flag just before it is
+// cleared and write the eventfd just after
+static void wake_clear(void) {
+    __atomic_store_n(&ctx->wake_pending, false, __ATOMIC_SEQ_CST);
+    uint64_t wakeups;
+    if (read(ctx->wake_fd, &wakeups, sizeof(wakeups)) < 0) {
+        // EAGAIN: nothing was signalled
+    }
+}
+
+static uint32_t next_user_event = BUMI_USEREVENT;
+
+uint32_t BUMI_RegisterEvents(int numevents) {
+    BUMI_ClearError();
+
+    if (numevents <= 0) {
+        set_error("Invalid number of events %d", numevents);
+        return (uint32_t) -1;
+    }
+    uint32_t first = __atomic_load_n(&next_user_event, __ATOMIC_RELAXED);
+    do {
+        if (first + (uint32_t) numevents - 1 > BUMI_LASTEVENT || first + (uint32_t) numevents < first) {
+            set_error("Out of user event types");
+            return (uint32_t) -1;
+        }
+    } while (!__atomic_compare_exchange_n(&next_user_event, &first, first + (uint32_t) numevents, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return first;
+}
+
+int BUMI_PushEvent(const BUMI_Event* event) {
+    BUMI_ClearError();
+
+    if (!ctx || !event) {
+        set_error("Event pushing requires initialized context and valid event pointer");
+        return -1;
+    }
+
+    uint32_t position = __atomic_load_n(&ctx->user_tail, __ATOMIC_RELAXED);
+    for (;;) {
+        uint32_t sequence = __atomic_load_n(&ctx->user_queue[position & (BUMI_USER_QUEUE_SIZE - 1)].sequence,
+                                            __ATOMIC_ACQUIRE);
+        int32_t turn = (int32_t)(sequence - position);
+        if (turn == 0) {
+            if (__atomic_compare_exchange_n(&ctx->user_tail, &position, position + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (turn < 0) {
+            set_error("Event queue is full");
+            return -1;
+        } else {
+            position = __atomic_load_n(&ctx->user_tail, __ATOMIC_RELAXED);
         }
-        return 0;
     }
 
+    BUMI_Event* cell = &ctx->user_queue[position & (BUMI_USER_QUEUE_SIZE - 1)].event;
+    *cell = *event;
+    cell->common.capture_ns = (uint64_t) monotonic_ns();
+    if (cell->common.timestamp == 0) {
+        cell->common.timestamp = cell->common.capture_ns;
+    }
+    __atomic_store_n(&ctx->user_queue[position & (BUMI_USER_QUEUE_SIZE - 1)].sequence, position + 1,
+                     __ATOMIC_RELEASE);
+    wake_main();
     return 0;
 }
 
-int BUMI_WaitEvent(BUMI_Event* event) {
+static void user_queue_drain(void) {
+    while (ctx->event_count < BUMI_EVENT_RING_SIZE) {
+        uint32_t position = ctx->user_head;
+        uint32_t index = position & (BUMI_USER_QUEUE_SIZE - 1);
+        if (__atomic_load_n(&ctx->user_queue[index].sequence, __ATOMIC_ACQUIRE) != position + 1) {
+            // Empty, or the producer that claimed this cell is still writing it
+            break;
+        }
+        event_push(&ctx->user_queue[index].event);
+        __atomic_store_n(&ctx->user_queue[index].sequence, position + BUMI_USER_QUEUE_SIZE, __ATOMIC_RELEASE);
+        ctx->user_head = position + 1;
+    }
+}
+
+// === INPUT THREAD ===
+
+// With BUMI_INIT_INPUT_THREAD, keyboard and pointer events are selected on
+// a second connection that a dedicated thread blocks on. It translates them
+// as they arrive and hands them over through a single-producer,
+// single-consumer ring; the pump moves them into the event queue, where
+// they coalesce as usual. Window events stay on the main connection, since
+// answering them touches renderers
+
+static void input_ring_drain(void) {
+    uint32_t head = ctx->input_head;
+    uint32_t tail = __atomic_load_n(&ctx->input_tail, __ATOMIC_ACQUIRE);
+    while (head != tail && ctx->event_count < BUMI_EVENT_RING_SIZE) {
+        event_push(&ctx->input_ring[head & (BUMI_INPUT_RING_SIZE - 1)]);
+        head++;
+    }
+    __atomic_store_n(&ctx->input_head, head, __ATOMIC_RELEASE);
+}
+
+static bool input_ring_full(void) {
+    return ctx->input_tail - __atomic_load_n(&ctx->input_head, __ATOMIC_ACQUIRE) == BUMI_INPUT_RING_SIZE;
+}
+
+static void input_ring_push(const BUMI_Event* event) {
+    ctx->input_ring[ctx->input_tail & (BUMI_INPUT_RING_SIZE - 1)] = *event;
+    __atomic_store_n(&ctx->input_tail, ctx->input_tail + 1, __ATOMIC_RELEASE);
+}
+
+static void* input_thread_main(void* arg) {
+    (void) arg;
+    input_prepare();
+
+    struct pollfd fds[2] = {
+        {ConnectionNumber(ctx->input_dpy), POLLIN, 0},
+        {ctx->input_stop_fd, POLLIN, 0}
+    };
+    for (;;) {
+        // Events that do not fit wait in Xlib's queue until the app catches up
+        bool pushed = false;
+        while (!input_ring_full() && XPending(ctx->input_dpy)) {
+            XEvent xevent;
+            XNextEvent(ctx->input_dpy, &xevent);
+
+            BUMI_Event event;
+            XPointer window = NULL;
+            if (xevent.type != GenericEvent) {
+                XFindContext(ctx->input_dpy, xevent.xany.window, ctx->window_context, &window);
+            }
+            event_init(&event, (BUMI_WindowID)(uintptr_t) window);
+            if (translate_input(&xevent, event.common.windowID, &event)) {
+                input_ring_push(&event);
+                pushed = true;
+            }
+        }
+        if (pushed) {
+            wake_main();
+        }
+
+        if (poll(fds, 2, input_ring_full() ? 1 : -1) < 0 && errno != EINTR) {
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+static int input_thread_start(void) {
+    ctx->input_dpy = XOpenDisplay(DisplayString(ctx->dpy));
+    if (!ctx->input_dpy) {
+        ctx->input_dpy = ctx->dpy;
+        set_error("Failed to open the input connection");
+        return -1;
+    }
+    ctx->input_stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctx->input_stop_fd < 0 || pthread_create(&ctx->input_thread, NULL, input_thread_main, NULL) != 0) {
+        if (ctx->input_stop_fd >= 0) close(ctx->input_stop_fd);
+        XCloseDisplay(ctx->input_dpy);
+        ctx->input_dpy = ctx->dpy;
+        set_error("Failed to start the input thread");
+        return -1;
+    }
+    ctx->input_threaded = true;
+    return 0;
+}
+
+static void input_thread_stop(void) {
+    if (!ctx->input_threaded) return;
+
+    uint64_t one = 1;
+    if (write(ctx->input_stop_fd, &one, sizeof(one)) == sizeof(one)) {
+        pthread_join(ctx->input_thread, NULL);
+    }
+    close(ctx->input_stop_fd);
+    XCloseDisplay(ctx->input_dpy);
+    ctx->input_dpy = ctx->dpy;
+    ctx->input_threaded = false;
+}
+
+// Move everything the server has sent into the ring: one read of the
+// connection, then the events it brought in. Events that do not fit stay
+// in Xlib's queue for the next pump
+static void event_pump(void) {
+    wake_clear();
+    user_queue_drain();
+    if (ctx->input_threaded) {
+        input_ring_drain();
+    } else {
+        input_prepare();
+    }
+    int pending = XEventsQueued(ctx->dpy, QueuedAfterFlush);
+    while (pending > 0 && ctx->event_count < BUMI_EVENT_RING_SIZE) {
+        XEvent xevent;
+        XNextEvent(ctx->dpy, &xevent);
+        pending--;
+
+        BUMI_Event event;
+        if (translate_event(&xevent, &event)) {
+            event_push(&event);
+        }
+        if (pending == 0) {
+            pending = XEventsQueued(ctx->dpy, QueuedAlready);
+        }
+    }
+}
+
+static int latency_bucket(uint64_t us) {
+    if (us < 16) {
+        return (int) us;
+    }
+    int octave = 63 - __builtin_clzll(us);
+    int index = 16 + (octave - 4) * 8 + (int)((us >> (octave - 3)) & 7);
+    return index < BUMI_LATENCY_BUCKETS ? index : BUMI_LATENCY_BUCKETS - 1;
+}
+
+static uint64_t latency_bucket_start_us(int index) {
+    if (index < 16) {
+        return (uint64_t) index;
+    }
+    return (uint64_t)(8 + (index - 16) % 8) << (1 + (index - 16) / 8);
+}
+
+// Events the app queued itself may carry any timestamp; skip those from the future
+static void latency_record(const BUMI_Event* event, int64_t now) {
+    if (event->common.timestamp == 0 || (int64_t) event->common.timestamp > now) {
+        return;
+    }
+    uint64_t latency = (uint64_t)(now - (int64_t) event->common.timestamp);
+    ctx->latency_buckets[latency_bucket(latency / 1000)]++;
+    ctx->latency_count++;
+    if (latency > ctx->latency_max_ns) {
+        ctx->latency_max_ns = latency;
+    }
+}
+
+static uint64_t latency_percentile(double fraction) {
+    uint64_t rank = (uint64_t)(fraction * (double) ctx->latency_count + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < BUMI_LATENCY_BUCKETS; i++) {
+        seen += ctx->latency_buckets[i];
+        if (seen >= rank) {
+            // Middle of the bucket, never past the largest sample
+            uint64_t start = latency_bucket_start_us(i);
+            uint64_t middle = (start + latency_bucket_start_us(i + 1)) * 500;
+            return middle < ctx->latency_max_ns ? middle : ctx->latency_max_ns;
+        }
+    }
+    return ctx->latency_max_ns;
+}
+
+int BUMI_GetEventLatency(BUMI_EventLatency* latency, bool reset) {
+    BUMI_ClearError();
+
+    if (!ctx || !latency) {
+        set_error("Event latency requires initialized context and valid stats pointer");
+        return -1;
+    }
+    latency->count = ctx->latency_count;
+    latency->p50_ns = ctx->latency_count ? latency_percentile(0.50) : 0;
+    latency->p99_ns = ctx->latency_count ? latency_percentile(0.99) : 0;
+    latency->max_ns = ctx->latency_max_ns;
+    if (reset) {
+        memset(ctx->latency_buckets, 0, sizeof(ctx->latency_buckets));
+        ctx->latency_count = 0;
+        ctx->latency_max_ns = 0;
+    }
+    return 0;
+}
+
+static bool event_take(BUMI_Event* event) {
+    if (ctx->event_count == 0) {
+        return false;
+    }
+    *event = ctx->event_ring[ctx->event_head];
+    latency_record(event, monotonic_ns());
+    ctx->event_head = (ctx->event_head + 1) & (BUMI_EVENT_RING_SIZE - 1);
+    ctx->event_count--;
+    return true;
+}
+
+void BUMI_PumpEvents(void) {
+    BUMI_ClearError();
+
+    if (!ctx) {
+        set_error("Event pumping requires initialized context");
+        return;
+    }
+    event_pump();
+}
+
+int BUMI_PeepEvents(BUMI_Event* events, int numevents, BUMI_EventAction action, uint32_t min_type, uint32_t max_type) {
+    BUMI_ClearError();
+
+    if (!ctx) {
+        set_error("Event peeking requires initialized context");
+        return -1;
+    }
+    if (numevents < 0 || (!events && action != BUMI_PEEKEVENT)) {
+        set_error("Invalid event array");
+        return -1;
+    }
+
+    if (action == BUMI_ADDEVENT) {
+        int added = 0;
+        while (added < numevents && event_push(&events[added])) {
+            added++;
+        }
+        return added;
+    }
+    if (action != BUMI_PEEKEVENT && action != BUMI_GETEVENT) {
+        set_error("Invalid event action %d", (int) action);
+        return -1;
+    }
+
+    // One pass that copies out matches and, for GETEVENT, compacts the rest
+    int found = 0;
+    int kept = 0;
+    int count = ctx->event_count;
+    int64_t now = monotonic_ns();
+    for (int i = 0; i < count; i++) {
+        BUMI_Event event = *event_at(i);
+        bool match = event.type >= min_type && event.type <= max_type && (!events || found < numevents);
+        if (match) {
+            if (events) {
+                events[found] = event;
+            }
+            found++;
+            if (action == BUMI_GETEVENT) {
+                latency_record(&event, now);
+                continue;
+            }
+        }
+        *event_at(kept++) = event;
+    }
+    ctx->event_count = kept;
+    return found;
+}
+
+int BUMI_PollEvent(BUMI_Event* event) {
     BUMI_ClearError();
 
     if (!ctx || !event) {
-        set_error("Event waiting requires initialized context and valid event pointer");
+        set_error("Event polling requires initialized context and valid event pointer");
         return 0;
     }
 
-    XEvent xevent;
-    XNextEvent(ctx->dpy, &xevent);
+    if (ctx->event_count == 0) {
+        event_pump();
+    }
+    return event_take(event) ? 1 : 0;
+}
 
-    memset(event, 0, sizeof(BUMI_Event));
-    event->key.timestamp = (uint32_t)(time(NULL) * 1000);
-    event->key.windowID = (BUMI_WindowID)(uintptr_t)xevent.xany.window;
+int BUMI_WaitEventTimeout(BUMI_Event* event, int ms) {
+    BUMI_ClearError();
 
-    BUMI_Window* window = find_window(xevent.xany.window);
+    if (!ctx || !event) {
+        set_error("Event waiting requires initialized context and valid event pointer");
+        return 0;
+    }
 
-    if (xevent.type == ClientMessage && xevent.xclient.data.l[0] == ctx->wm_delete) {
-        event->type = BUMI_WINDOWEVENT;
-        event->window.window_event = BUMI_WINDOWEVENT_CLOSE;
-        return 1;
-    } else if (xevent.type == KeyPress) {
-        event->type = BUMI_KEYDOWN;
-        event->key.keycode = x11_to_bumi_keycode(XKeycodeToKeysym(ctx->dpy, xevent.xkey.keycode, 0));
-        return 1;
-    } else if (xevent.type == KeyRelease) {
-        event->type = BUMI_KEYUP;
-        event->key.keycode = x11_to_bumi_keycode(XKeycodeToKeysym(ctx->dpy, xevent.xkey.keycode, 0));
-        return 1;
-    } else if (xevent.type == ConfigureNotify) {
-        if (window) {
-            window->w = xevent.xconfigure.width;
-            window->h = xevent.xconfigure.height;
-            window->x = xevent.xconfigure.x;
-            window->y = xevent.xconfigure.y;
-            event->type = BUMI_WINDOWEVENT;
-            event->window.window_event = BUMI_WINDOWEVENT_RESIZED;
+    int64_t deadline = ms >= 0 ? monotonic_ns() + (int64_t) ms * 1000000LL : 0;
+    for (;;) {
+        if (ctx->event_count == 0) {
+            event_pump();
+        }
+        if (event_take(event)) {
             return 1;
         }
-        return 0;
-    } else if (xevent.type == Expose) {
-        if (window) {
-            if (window->renderers) {
-                BUMI_Renderer* renderer = window->renderers;
-                BUMI_RenderClear(renderer);
-                BUMI_RenderFillRect(renderer, NULL);
-                BUMI_RenderPresent(renderer);
-            } else if (window->flags & BUMI_WINDOW_CLEAR) {
-                GC gc = XCreateGC(ctx->dpy, xevent.xexpose.window, 0, NULL);
-                XSetForeground(ctx->dpy, gc, BlackPixel(ctx->dpy, ctx->screen));
-                XFillRectangle(ctx->dpy, xevent.xexpose.window, gc, 0, 0, window->w, window->h);
-                XFreeGC(ctx->dpy, gc);
-                XFlush(ctx->dpy);
+
+        // The pump flushed our requests and drained Xlib's queue, so the
+        // socket becoming readable, or another thread queuing events, is
+        // the only thing left to wait for
+        int timeout = -1;
+        if (ms >= 0) {
+            int64_t left = deadline - monotonic_ns();
+            if (left <= 0) {
+                return 0;
             }
+            timeout = (int)((left + 999999) / 1000000);
+        }
+        struct pollfd fds[2] = {
+            {ConnectionNumber(ctx->dpy), POLLIN, 0},
+            {ctx->wake_fd, POLLIN, 0}
+        };
+        if (poll(fds, 2, timeout) < 0 && errno != EINTR) {
+            set_error("Failed to wait on the X connection: %s", strerror(errno));
+            return 0;
         }
-        return 0;
     }
+}
 
-    return 0;
-}
\ No newline at end of file
+int BUMI_WaitEvent(BUMI_Event* event) {
+    return BUMI_WaitEventTimeout(event, -1);
+}
@@ -29,6 +29,10 @@ extern "C" {
 
 // Initialization flags (like SDL_INIT_VIDEO)
 #define BUMI_INIT_VIDEO 0x00000001u
+// Read keyboard and pointer input on a dedicated thread, so it is
+// timestamped and queued while the app renders. Events must still be
+// polled from a single thread
+#define BUMI_INIT_INPUT_THREAD 0x00000002u
 #define BUMI_WINDOW_CLEAR 0x00000001u // Flag to clear window to black
 
 typedef uint32_t BUMI_WindowID;
@@ -37,15 +41,57 @@ typedef uint64_t BUMI_WindowFlags;
 
 struct BUMI_Window;
 
+// Renderer flags, passed to BUMI_RendererCreate
+#define BUMI_RENDERER_SOFTWARE 0x00000001u    // CPU rasterizer presenting through MIT-SHM
+#define BUMI_RENDERER_ACCELERATED 0x00000002u // OpenGL through GLX
+// Present only the regions drawn since the last present and answer Expose
+// from the retained frame. The GL backend needs GLX_MESA_copy_sub_buffer
+// for this and does not sync to vblank in this mode; the software backend
+// always presents this way
+#define BUMI_RENDERER_PARTIAL_PRESENT 0x00000004u
+
+struct BUMI_Texture;
+struct BUMI_RenderDriver;
+struct BUMI_Capture;
+
+// Timestamps of a completed swap (GLX_OML_sync_control)
+typedef struct {
+    int64_t ust; // Microseconds the frame reached the screen (CLOCK_MONOTONIC on Mesa)
+    int64_t msc; // Vertical retrace counter at that time
+    int64_t sbc; // Swap counter of the frame
+} BUMI_PresentTiming;
+
 typedef struct BUMI_Renderer { 
     struct BUMI_Window* window; 
     struct BUMI_Renderer* next; 
     struct BUMI_Renderer* previous; 
-    void* renderer_data; 
-    //GLX context 
+    void* renderer_data; // Backend data (GLX context or software framebuffer)
     float draw_color[4]; // RGBA draw color 
+    struct BUMI_Texture* textures; // Linked list head
+    const struct BUMI_RenderDriver* driver; // Backend the renderer was created on
+    uint32_t flags; // BUMI_RENDERER_* flags it was created with
+    struct BUMI_Texture* target; // Current render target, NULL for the window
+    struct BUMI_Capture* capture; // Active frame capture, NULL when not recording
 } BUMI_Renderer;
 
+// Texture pixel formats, named by byte order in memory
+#define BUMI_PIXELFORMAT_RGBA32 1u
+#define BUMI_PIXELFORMAT_BGRA32 2u
+
+#define BUMI_TEXTUREACCESS_STATIC 0    // Changes rarely, updated with BUMI_TextureUpdate
+#define BUMI_TEXTUREACCESS_STREAMING 1 // Changes often, lockable
+#define BUMI_TEXTUREACCESS_TARGET 2    // Can be rendered into with BUMI_SetRenderTarget
+
+typedef struct BUMI_Texture {
+    struct BUMI_Renderer* renderer;
+    uint32_t format;
+    int access;
+    int w, h;
+    struct BUMI_Texture* next;
+    struct BUMI_Texture* previous;
+    void* texture_data; // Backend data (GL texture and upload buffers)
+} BUMI_Texture;
+
 
 typedef struct BUMI_Window {
     BUMI_WindowID id;
@@ -78,6 +124,22 @@ typedef struct {
     int w, h; 
 } BUMI_Rect;
 
+typedef struct {
+    uint8_t r, g, b, a;
+} BUMI_Color;
+
+typedef struct {
+    int x, y;
+} BUMI_Point;
+
+// Corner of a triangle for BUMI_RenderGeometry: position in pixels, color,
+// and texture coordinates normalized to 0..1 (unused without a texture)
+typedef struct {
+    float x, y;
+    BUMI_Color color;
+    float u, v;
+} BUMI_Vertex;
+
 // Initialize the Bumi system (like SDL_Init)
 int BUMI_Init(
     uint32_t             // flags
@@ -86,6 +148,40 @@ int BUMI_Init(
 // Clean up the Bumi system (like SDL_Quit)
 void BUMI_Quit(void);
 
+// Startup latency, measured from the start of BUMI_Init (or the first
+// BUMI_WindowCreate, if that opened the display). A field is 0 until the
+// step it marks has happened
+typedef struct {
+    int64_t init_ns;          // Opening the display, interning atoms, resolving the GLX config
+    int64_t first_window_ns;  // Until the first window was created
+    int64_t first_present_ns; // Until the first BUMI_RenderPresent returned
+} BUMI_StartupTiming;
+
+int BUMI_GetStartupTiming(BUMI_StartupTiming* timing);
+
+// Nanoseconds on CLOCK_MONOTONIC, the clock event timestamps are on
+uint64_t BUMI_GetTicksNS(void);
+// A high-resolution counter for measuring intervals, and its ticks per second
+uint64_t BUMI_GetPerformanceCounter(void);
+uint64_t BUMI_GetPerformanceFrequency(void);
+
+// Allocator behind everything the library allocates (like
+// SDL_SetMemoryFunctions). Change it only before BUMI_Init, while nothing
+// the library allocated is alive
+typedef void* (*BUMI_malloc_func)(size_t size);
+typedef void* (*BUMI_calloc_func)(size_t count, size_t size);
+typedef void* (*BUMI_realloc_func)(void* ptr, size_t size);
+typedef void (*BUMI_free_func)(void* ptr);
+
+int BUMI_SetMemoryFunctions(BUMI_malloc_func malloc_func, BUMI_calloc_func calloc_func,
+                            BUMI_realloc_func realloc_func, BUMI_free_func free_func);
+void BUMI_GetMemoryFunctions(BUMI_malloc_func* malloc_func, BUMI_calloc_func* calloc_func,
+                             BUMI_realloc_func* realloc_func, BUMI_free_func* free_func);
+// Allocations the library has made so far. Windows and renderers come from
+// pools and transient draw data from a per-frame arena, so once warmed up
+// a render loop leaves this unchanged
+uint64_t BUMI_GetAllocationCount(void);
+
 // Get the last error message (like SDL_GetError)
 const char* BUMI_GetError(void);
 
@@ -105,6 +201,16 @@ BUMI_Window* BUMI_WindowCreate(
 void BUMI_WindowDestroy(
     BUMI_Window*                     // window
 );
+// Window IDs are small, sequential and never reused while the library is
+// initialized; events carry them in their windowID field
+BUMI_Window* BUMI_GetWindowFromID(BUMI_WindowID id);
+// Render backends, in the order BUMI_RendererCreate tries them. Pass an
+// index to force one, or -1 to take the first that matches `flags`
+// (the BUMI_RENDER_DRIVER environment variable can name one by name):
+// "opengl_core" (3.3 core, shaders), "opengl" (fixed function), "software"
+int BUMI_GetNumRenderDrivers(void);
+const char* BUMI_GetRenderDriverName(int index);
+
 BUMI_Renderer* BUMI_RendererCreate(
     BUMI_Window*,                    // window
     int,                             // index
@@ -122,13 +228,190 @@ int BUMI_PollEvent(
 int BUMI_WaitEvent(
     BUMI_Event*                     // event
 );
+// Mouse motion is coalesced per window: a sample merges into the newest
+// queued event when that is motion for the same window, with the deltas
+// summed, so motion never moves past key or button events. With
+// full resolution every sample is queued with its own timestamp. Deltas
+// come from XInput2 raw motion when the library is built with its headers
+int BUMI_SetMouseFullResolution(bool enabled);
+// Keys held as of the last event pump, one bit per BUMI_KEY_INDEX; test
+// with BUMI_KEY_HELD. The array stays valid until BUMI_Quit
+const uint32_t* BUMI_GetKeyboardState(int* numkeys);
+// Wait up to `ms` milliseconds (< 0 waits forever) for an event, sleeping
+// on the X connection. Returns 1 with an event, 0 on timeout or error
+int BUMI_WaitEventTimeout(BUMI_Event* event, int ms);
+
+// Events are translated in bulk into an internal queue. A newer resize or
+// expose of a window replaces an older one still queued, so each frame
+// only sees the latest state
+typedef enum {
+    BUMI_ADDEVENT,  // Append events to the queue
+    BUMI_PEEKEVENT, // Copy out matching events and leave them queued
+    BUMI_GETEVENT   // Copy out matching events and remove them
+} BUMI_EventAction;
+
+// Move pending X events into the queue; BUMI_PollEvent does this itself
+void BUMI_PumpEvents(void);
+// Act on up to `numevents` queued events with min_type <= type <= max_type
+// (BUMI_FIRSTEVENT, BUMI_LASTEVENT for all) and return how many. Does not
+// pump. PEEKEVENT with NULL events counts the matches
+int BUMI_PeepEvents(BUMI_Event* events, int numevents, BUMI_EventAction action, uint32_t min_type, uint32_t max_type);
+
+// Reserve `numevents` consecutive event types for the app and return the
+// first, or (uint32_t) -1 when the range is used up. Safe from any thread
+uint32_t BUMI_RegisterEvents(int numevents);
+// Queue an event from any thread, waking a BUMI_WaitEvent in progress. It
+// reaches the app with the next pump, stamped now if its timestamp is 0.
+// Fails when 1024 pushed events are waiting
+int BUMI_PushEvent(const BUMI_Event* event);
+
+// Time from each event's timestamp until the app dequeued it, over every
+// event taken since BUMI_Init or the last reset. Percentiles come from a
+// log-scale histogram and are accurate to about 6%
+typedef struct {
+    uint64_t count;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+} BUMI_EventLatency;
+
+int BUMI_GetEventLatency(BUMI_EventLatency* latency, bool reset);
 
 int BUMI_SetRenderDrawColor(BUMI_Renderer* renderer, uint8_t r, uint8_t g, uint8_t b, uint8_t a); 
 int BUMI_RenderClear(BUMI_Renderer* renderer); 
-int BUMI_RenderFillRect(BUMI_Renderer* renderer, const BUMI_Rect* rect); \
+int BUMI_RenderFillRect(BUMI_Renderer* renderer, const BUMI_Rect* rect);
+
+// Queue several rectangles at once. Consecutive fills are batched and
+// submitted as one draw call on BUMI_RenderPresent
+int BUMI_RenderFillRects(BUMI_Renderer* renderer, const BUMI_Rect* rects, int count);
+// Fill `count` rects, each with its own color (NULL colors uses the draw
+// color), in one instanced draw call. Meant for very large, per-frame
+// changing sets; contexts without instancing expand them on the CPU
+int BUMI_RenderFillRectsInstanced(BUMI_Renderer* renderer, const BUMI_Rect* rects, const BUMI_Color* colors, int count);
+// Draw a triangle list. `indices` picks three vertices per triangle, or is
+// NULL to take the vertices in order. Colors interpolate across each
+// triangle; with a texture, its texels are multiplied by them and blended.
+// The triangles join the pending batch like rect fills
+int BUMI_RenderGeometry(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Vertex* vertices, int num_vertices,
+                        const int* indices, int num_indices);
+// One pixel wide connected line through `count` points, in the draw color
+int BUMI_RenderLines(BUMI_Renderer* renderer, const BUMI_Point* points, int count);
+int BUMI_RenderPoints(BUMI_Renderer* renderer, const BUMI_Point* points, int count);
 void BUMI_RenderPresent(BUMI_Renderer* renderer); 
+// Present every renderer drawn to since its last present, in one pass per
+// backend, and return how many. GL windows only switch contexts to submit
+// draws still queued (and to read back frames being captured); the swaps
+// themselves need none. With GLX_EXT_swap_control only the last swap waits
+// for vertical blank and the rest show at once; with glXSwapIntervalMESA
+// alone each swap keeps its own interval. Renderers with a render target
+// set are skipped
+int BUMI_RenderPresentAll(void);
 void BUMI_Delay(uint32_t ms);
 
+// 0 presents immediately, 1 waits for vertical blank, -1 adaptive vsync
+// where GLX_EXT_swap_control_tear is available
+int BUMI_SetSwapInterval(BUMI_Renderer* renderer, int interval);
+// Timing of the most recent frame the display has shown
+int BUMI_GetPresentTiming(BUMI_Renderer* renderer, BUMI_PresentTiming* timing);
+// Refresh rate in Hz of the screen the window is on (60 if it cannot be read)
+double BUMI_GetRefreshRate(BUMI_Window* window);
+
+// Frame pacer: keeps a loop on a fixed frame grid by sleeping on an absolute
+// deadline and spinning for the last moments. hz <= 0 uses the refresh rate
+typedef struct BUMI_Capture BUMI_Capture;
+typedef struct BUMI_FramePacer BUMI_FramePacer;
+
+BUMI_FramePacer* BUMI_FramePacerCreate(BUMI_Window* window, double hz);
+void BUMI_FramePacerDestroy(BUMI_FramePacer* pacer);
+void BUMI_FramePacerWait(BUMI_FramePacer* pacer);
+
+BUMI_Texture* BUMI_TextureCreate(BUMI_Renderer* renderer, uint32_t format, int access, int w, int h);
+void BUMI_TextureDestroy(BUMI_Texture* texture);
+// Copy 4-byte pixels into the texture; a NULL rect updates all of it
+int BUMI_TextureUpdate(BUMI_Texture* texture, const BUMI_Rect* rect, const void* pixels, int pitch);
+// Write-only access to a streaming texture. The returned memory is a mapped
+// pixel buffer, uploaded asynchronously on unlock
+int BUMI_TextureLock(BUMI_Texture* texture, const BUMI_Rect* rect, void** pixels, int* pitch);
+void BUMI_TextureUnlock(BUMI_Texture* texture);
+// Any renderer on the texture's driver can draw it, in any window; GL
+// contexts of a driver share one resource list. The texture still lives
+// and dies with the renderer that created it
+int BUMI_RenderCopy(BUMI_Renderer* renderer, BUMI_Texture* texture, const BUMI_Rect* src, const BUMI_Rect* dst);
+
+// Redirect drawing into a BUMI_TEXTUREACCESS_TARGET texture; NULL restores
+// the window. Clear, fill and copy behave the same on either output
+int BUMI_SetRenderTarget(BUMI_Renderer* renderer, BUMI_Texture* texture);
+// Read back the current output, top row first; a NULL rect reads all of it
+int BUMI_RenderReadPixels(BUMI_Renderer* renderer, const BUMI_Rect* rect, uint32_t format, void* pixels, int pitch);
+
+// Frame capture: every presented frame is read back without stalling
+// BUMI_RenderPresent (PBO ring and fences on GL) and a writer thread streams
+// it to a file. Frames keep the window size capture started with; when the
+// writer falls behind, frames are dropped and counted instead of queued
+#define BUMI_CAPTURE_Y4M 0 // YUV4MPEG2 4:2:0
+#define BUMI_CAPTURE_RAW 1 // Headerless top-down BGRA frames
+
+typedef struct {
+    uint64_t captured; // Frames handed to the writer
+    uint64_t written;  // Frames the writer finished
+    uint64_t dropped;  // Frames skipped because the queue or readback ring was full
+} BUMI_CaptureStats;
+
+int BUMI_RenderStartCapture(BUMI_Renderer* renderer, const char* path, int format, int fps);
+// Waits for in-flight frames to be written; fails if any write failed
+int BUMI_RenderStopCapture(BUMI_Renderer* renderer);
+int BUMI_RenderGetCaptureStats(BUMI_Renderer* renderer, BUMI_CaptureStats* stats);
+
+// Texture atlas: packs many small images into a few large pages so sprites
+// drawn from the same page share one texture and one draw call. Destroy an
+// atlas before the renderer it was created on.
+typedef struct BUMI_Atlas BUMI_Atlas;
+
+BUMI_Atlas* BUMI_AtlasCreate(BUMI_Renderer* renderer, uint32_t format, int page_w, int page_h);
+void BUMI_AtlasDestroy(BUMI_Atlas* atlas);
+// Pack and upload an image; returns its sprite id, or -1 on error
+int BUMI_AtlasAdd(BUMI_Atlas* atlas, const void* pixels, int w, int h, int pitch);
+int BUMI_AtlasGetSprite(const BUMI_Atlas* atlas, int sprite, BUMI_Texture** page, BUMI_Rect* rect);
+int BUMI_RenderSprite(BUMI_Renderer* renderer, BUMI_Atlas* atlas, int sprite, const BUMI_Rect* dst);
+// Draws are grouped by atlas page, so draw order only holds between sprites
+// on the same page
+int BUMI_RenderSprites(BUMI_Renderer* renderer, BUMI_Atlas* atlas, const int* sprites, const BUMI_Rect* dsts, int count);
+
+// Text: glyphs of the built-in 5x7 ASCII font are rasterized once at an
+// integer scale into a glyph cache texture; when it fills up, the least
+// recently drawn glyph is evicted. Other codepoints draw as a box. A font
+// can be drawn by any renderer on the driver it was created on; destroy it
+// before that renderer.
+typedef struct BUMI_Font BUMI_Font;
+
+BUMI_Font* BUMI_FontCreate(BUMI_Renderer* renderer, int scale);
+void BUMI_FontDestroy(BUMI_Font* font);
+int BUMI_FontGetCacheStats(const BUMI_Font* font, uint64_t* hits, uint64_t* misses);
+// Size of UTF-8 `text` as BUMI_RenderText would lay it out
+int BUMI_TextSize(const BUMI_Font* font, const char* text, int* w, int* h);
+// Draw UTF-8 `text` in the draw color with its top-left at x, y; '\n'
+// starts a new line. The glyph quads join the renderer's current batch
+int BUMI_RenderText(BUMI_Renderer* renderer, BUMI_Font* font, const char* text, int x, int y);
+
+// Deferred rendering: a command buffer records draw commands into a compact
+// stream without touching GL, so frames can be built on worker threads and
+// submitted from the thread that owns the renderer. A buffer must only be
+// recorded by one thread at a time.
+typedef struct BUMI_CommandBuffer BUMI_CommandBuffer;
+
+BUMI_CommandBuffer* BUMI_CommandBufferCreate(void);
+void BUMI_CommandBufferDestroy(BUMI_CommandBuffer* buffer);
+void BUMI_CommandBufferReset(BUMI_CommandBuffer* buffer);
+int BUMI_CmdSetDrawColor(BUMI_CommandBuffer* buffer, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+int BUMI_CmdClear(BUMI_CommandBuffer* buffer);
+int BUMI_CmdFillRect(BUMI_CommandBuffer* buffer, const BUMI_Rect* rect);
+int BUMI_CmdFillRects(BUMI_CommandBuffer* buffer, const BUMI_Rect* rects, int count);
+int BUMI_CmdPresent(BUMI_CommandBuffer* buffer);
+
+// Replay a recorded buffer on the renderer's thread. Redundant state and
+// fills hidden by a later clear are dropped; the buffer is left unchanged
+int BUMI_SubmitCommandBuffer(BUMI_Renderer* renderer, const BUMI_CommandBuffer* buffer);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,121 @@
+#include <ventor/bumi_sysvideo.h>
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+
+static const int RECTS_PER_FRAME = 4000;
+static const int FRAMES = 60;
+
+// Reference for the pre-batching path: one make-current, projection rebuild
+// and glBegin/glEnd quad per rectangle
+static void legacy_fill_rect(Display* dpy, GLXDrawable drawable, GLXContext context, BUMI_Window* window,
+                             const float color[4], const BUMI_Rect& rect) {
+    glXMakeCurrent(dpy, drawable, context);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, window->w, window->h, 0, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    glColor4fv(color);
+    glBegin(GL_QUADS);
+    glVertex2f(rect.x, rect.y);
+    glVertex2f(rect.x + rect.w, rect.y);
+    glVertex2f(rect.x + rect.w, rect.y + rect.h);
+    glVertex2f(rect.x, rect.y + rect.h);
+    glEnd();
+}
+
+static void report(const char* name, std::chrono::steady_clock::duration elapsed) {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double rects = (double) RECTS_PER_FRAME * FRAMES;
+    std::cout << name << ": " << (long long)(rects / seconds) << " rects/s ("
+              << seconds * 1000.0 / FRAMES << " ms/frame)" << std::endl;
+}
+
+int main() {
+    if (BUMI_Init(BUMI_INIT_VIDEO) != 0) {
+        std::cout << "Bench failed: Initialization error: " << BUMI_GetError() << std::endl;
+        return 1;
+    }
+
+    BUMI_Window* window = BUMI_WindowCreate("FillRect Bench", 100, 100, 800, 600, BUMI_WINDOW_CLEAR);
+    if (!window) {
+        std::cout << "Bench failed: Window creation error: " << BUMI_GetError() << std::endl;
+        BUMI_Quit();
+        return 1;
+    }
+
+    // The immediate-mode reference needs the fixed-function driver
+    int driver = -1;
+    for (int i = 0; i < BUMI_GetNumRenderDrivers(); i++) {
+        if (std::string(BUMI_GetRenderDriverName(i)) == "opengl") {
+            driver = i;
+        }
+    }
+    BUMI_Renderer* renderer = BUMI_RendererCreate(window, driver, 0);
+    if (!renderer) {
+        std::cout << "Bench failed: Renderer creation error: " << BUMI_GetError() << std::endl;
+        BUMI_WindowDestroy(window);
+        BUMI_Quit();
+        return 1;
+    }
+
+    // The renderer leaves its context current after creation
+    Display* dpy = glXGetCurrentDisplay();
+    GLXDrawable drawable = glXGetCurrentDrawable();
+    GLXContext context = glXGetCurrentContext();
+
+    std::vector<BUMI_Rect> rects(RECTS_PER_FRAME);
+    for (int i = 0; i < RECTS_PER_FRAME; i++) {
+        rects[i].x = (i * 37) % (window->w - 16);
+        rects[i].y = (i * 53) % (window->h - 16);
+        rects[i].w = 4 + i % 12;
+        rects[i].h = 4 + (i / 12) % 12;
+    }
+    const float red[4] = {1.0f, 0.0f, 0.0f, 1.0f};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < FRAMES; frame++) {
+        BUMI_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        BUMI_RenderClear(renderer);
+        for (int i = 0; i < RECTS_PER_FRAME; i++) {
+            legacy_fill_rect(dpy, drawable, context, window, red, rects[i]);
+        }
+        BUMI_RenderPresent(renderer);
+    }
+    glFinish();
+    report("Immediate mode (before)", std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < FRAMES; frame++) {
+        BUMI_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        BUMI_RenderClear(renderer);
+        BUMI_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+        for (int i = 0; i < RECTS_PER_FRAME; i++) {
+            BUMI_RenderFillRect(renderer, &rects[i]);
+        }
+        BUMI_RenderPresent(renderer);
+    }
+    glFinish();
+    report("BUMI_RenderFillRect auto-batched (after)", std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < FRAMES; frame++) {
+        BUMI_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        BUMI_RenderClear(renderer);
+        BUMI_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+        BUMI_RenderFillRects(renderer, rects.data(), RECTS_PER_FRAME);
+        BUMI_RenderPresent(renderer);
+    }
+    glFinish();
+    report("BUMI_RenderFillRects (after)", std::chrono::steady_clock::now() - start);
+
+    BUMI_RendererDestroy(renderer);
+    BUMI_WindowDestroy(window);
+    BUMI_Quit();
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <ventor/bumi_sysvideo.h>
+#include <GL/gl.h>
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+
+static const int INSTANCES = 200000;
+static const int FRAMES = 60;
+
+static void report(const char* name, std::chrono::steady_clock::duration elapsed) {
+    double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+    double instances = (double) INSTANCES * FRAMES;
+    std::cout << name << ": " << (long long)(instances / ms) << " instances/ms ("
+              << ms / FRAMES << " ms/frame)" << std::endl;
+}
+
+// Particles bounce around the window; every rect moves every frame
+static void step(std::vector<BUMI_Rect>& rects, std::vector<int>& velocity, int w, int h) {
+    for (size_t i = 0; i < rects.size(); i++) {
+        BUMI_Rect& r = rects[i];
+        r.x += velocity[i * 2];
+        r.y += velocity[i * 2 + 1];
+        if (r.x < 0 || r.x > w - r.w) velocity[i * 2] = -velocity[i * 2];
+        if (r.y < 0 || r.y > h - r.h) velocity[i * 2 + 1] = -velocity[i * 2 + 1];
+    }
+}
+
+int main() {
+    if (BUMI_Init(BUMI_INIT_VIDEO) != 0) {
+        std::cout << "Bench failed: Initialization error: " << BUMI_GetError() << std::endl;
+        return 1;
+    }
+
+    BUMI_Window* window = BUMI_WindowCreate("Instanced Bench", 100, 100, 1024, 768, BUMI_WINDOW_CLEAR);
+    if (!window) {
+        std::cout << "Bench failed: Window creation error: " << BUMI_GetError() << std::endl;
+        BUMI_Quit();
+        return 1;
+    }
+
+    BUMI_Renderer* renderer = BUMI_RendererCreate(window, -1, 0);
+    if (!renderer) {
+        std::cout << "Bench failed: Renderer creation error: " << BUMI_GetError() << std::endl;
+        BUMI_WindowDestroy(window);
+        BUMI_Quit();
+        return 1;
+    }
+
+    std::vector<BUMI_Rect> rects(INSTANCES);
+    std::vector<BUMI_Color> colors(INSTANCES);
+    std::vector<int> velocity(INSTANCES * 2);
+    srand(1);
+    for (int i = 0; i < INSTANCES; i++) {
+        rects[i].w = 2 + rand() % 4;
+        rects[i].h = 2 + rand() % 4;
+        rects[i].x = rand() % (window->w - rects[i].w);
+        rects[i].y = rand() % (window->h - rects[i].h);
+        velocity[i * 2] = 1 + rand() % 3;
+        velocity[i * 2 + 1] = 1 + rand() % 3;
+        colors[i].r = (uint8_t) rand();
+        colors[i].g = (uint8_t) rand();
+        colors[i].b = (uint8_t) rand();
+        colors[i].a = 255;
+    }
+
+    // Baseline: per-rect colors through the CPU-built quad batch
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < FRAMES; frame++) {
+        step(rects, velocity, window->w, window->h);
+        BUMI_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        BUMI_RenderClear(renderer);
+        for (int i = 0; i < INSTANCES; i++) {
+            BUMI_SetRenderDrawColor(renderer, colors[i].r, colors[i].g, colors[i].b, colors[i].a);
+            BUMI_RenderFillRects(renderer, &rects[i], 1);
+        }
+        BUMI_RenderPresent(renderer);
+    }
+    glFinish();
+    report("BUMI_RenderFillRects per color (before)", std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < FRAMES; frame++) {
+        step(rects, velocity, window->w, window->h);
+        BUMI_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        BUMI_RenderClear(renderer);
+        if (BUMI_RenderFillRectsInstanced(renderer, rects.data(), colors.data(), INSTANCES) != 0) {
+            std::cout << "Bench failed: " << BUMI_GetError() << std::endl;
+            return 1;
+        }
+        BUMI_RenderPresent(renderer);
+    }
+    glFinish();
+    report("BUMI_RenderFillRectsInstanced (after)", std::chrono::steady_clock::now() - start);
+
+    BUMI_RendererDestroy(renderer);
+    BUMI_WindowDestroy(window);
+    BUMI_Quit();
+    return 0;
+}
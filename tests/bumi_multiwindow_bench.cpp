@@ -0,0 +1,95 @@
+#include <ventor/bumi_sysvideo.h>
+#include <GL/gl.h>
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+static const int FRAMES = 30;
+static const int WINDOW_COUNTS[] = {1, 4, 16, 64, 256};
+
+struct Pane {
+    BUMI_Window* window;
+    BUMI_Renderer* renderer;
+};
+
+static void report(const char* name, int windows, std::chrono::steady_clock::duration elapsed) {
+    double ms = std::chrono::duration<double, std::milli>(elapsed).count() / FRAMES;
+    std::cout << "  " << name << ": " << ms << " ms/frame (" << ms * 1000.0 / windows << " us/window)" << std::endl;
+}
+
+// A monitoring-wall style frame: each pane gets a background and a moving bar
+static void draw(const Pane& pane, int index, int frame) {
+    BUMI_SetRenderDrawColor(pane.renderer, 16, 16, (uint8_t)(index * 7), 255);
+    BUMI_RenderClear(pane.renderer);
+    BUMI_Rect bar = {(frame * 4 + index) % (pane.window->w - 20), 40, 20, 40};
+    BUMI_SetRenderDrawColor(pane.renderer, 0, 200, 80, 255);
+    BUMI_RenderFillRect(pane.renderer, &bar);
+}
+
+static void destroy(std::vector<Pane>& panes) {
+    for (size_t i = 0; i < panes.size(); i++) {
+        BUMI_RendererDestroy(panes[i].renderer);
+        BUMI_WindowDestroy(panes[i].window);
+    }
+    panes.clear();
+}
+
+int main() {
+    if (BUMI_Init(BUMI_INIT_VIDEO) != 0) {
+        std::cout << "Bench failed: Initialization error: " << BUMI_GetError() << std::endl;
+        return 1;
+    }
+
+    for (int count : WINDOW_COUNTS) {
+        std::vector<Pane> panes;
+        for (int i = 0; i < count; i++) {
+            Pane pane;
+            pane.window = BUMI_WindowCreate("Multi-window Bench", (i % 16) * 100, (i / 16) * 60, 160, 120, 0);
+            pane.renderer = pane.window ? BUMI_RendererCreate(pane.window, -1, 0) : NULL;
+            if (!pane.renderer) {
+                std::cout << "Bench failed: Window " << i << " of " << count << ": " << BUMI_GetError() << std::endl;
+                if (pane.window) {
+                    BUMI_WindowDestroy(pane.window);
+                }
+                destroy(panes);
+                BUMI_Quit();
+                return 1;
+            }
+            panes.push_back(pane);
+        }
+        std::cout << count << " windows:" << std::endl;
+
+        // Baseline: each window drawn and presented in turn
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < FRAMES; frame++) {
+            BUMI_PumpEvents();
+            for (int i = 0; i < count; i++) {
+                draw(panes[i], i, frame);
+                BUMI_RenderPresent(panes[i].renderer);
+            }
+        }
+        glFinish();
+        report("BUMI_RenderPresent per window (before)", count, std::chrono::steady_clock::now() - start);
+
+        start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < FRAMES; frame++) {
+            BUMI_PumpEvents();
+            for (int i = 0; i < count; i++) {
+                draw(panes[i], i, frame);
+            }
+            if (BUMI_RenderPresentAll() != count) {
+                std::cout << "Bench failed: " << BUMI_GetError() << std::endl;
+                destroy(panes);
+                BUMI_Quit();
+                return 1;
+            }
+        }
+        glFinish();
+        report("BUMI_RenderPresentAll (after)", count, std::chrono::steady_clock::now() - start);
+
+        destroy(panes);
+    }
+
+    BUMI_Quit();
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <cstdint>
 
 int main() {
     if (BUMI_Init(BUMI_INIT_VIDEO) != 0) {
@@ -24,6 +25,53 @@ int main() {
         return 1;
     }
 
+    // Offscreen: draw into a target and read it back without looking at it
+    bool target_ok = false;
+    BUMI_Texture* target = BUMI_TextureCreate(renderer, BUMI_PIXELFORMAT_RGBA32, BUMI_TEXTUREACCESS_TARGET, 64, 64);
+    if (target && BUMI_SetRenderTarget(renderer, target) == 0) {
+        BUMI_Rect quarter = {0, 0, 32, 32};
+        BUMI_SetRenderDrawColor(renderer, 0, 0, 255, 255);
+        BUMI_RenderClear(renderer);
+        BUMI_SetRenderDrawColor(renderer, 0, 255, 0, 255);
+        BUMI_RenderFillRect(renderer, &quarter);
+
+        uint8_t pixels[64 * 64 * 4];
+        if (BUMI_RenderReadPixels(renderer, NULL, BUMI_PIXELFORMAT_RGBA32, pixels, 64 * 4) == 0) {
+            const uint8_t* inside = pixels + (8 * 64 + 8) * 4;
+            const uint8_t* outside = pixels + (48 * 64 + 48) * 4;
+            target_ok = inside[0] == 0 && inside[1] == 255 && inside[2] == 0 &&
+                        outside[0] == 0 && outside[1] == 0 && outside[2] == 255;
+        }
+        BUMI_SetRenderTarget(renderer, NULL);
+    }
+    if (!target_ok) {
+        std::cout << "Render target readback error: " << BUMI_GetError() << std::endl;
+    }
+    BUMI_TextureDestroy(target);
+
+    // Draws interleaved across two windows must all go out with one
+    // BUMI_RenderPresentAll, leaving nothing queued behind
+    bool present_all_ok = false;
+    BUMI_Window* second = BUMI_WindowCreate("Second Window", 200, 200, 320, 240, 0);
+    BUMI_Renderer* second_renderer = second ? BUMI_RendererCreate(second, -1, 0) : NULL;
+    if (second_renderer) {
+        BUMI_Rect box = {10, 10, 50, 50};
+        BUMI_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        BUMI_SetRenderDrawColor(second_renderer, 0, 0, 0, 255);
+        BUMI_RenderClear(renderer);
+        BUMI_RenderClear(second_renderer);
+        BUMI_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+        BUMI_SetRenderDrawColor(second_renderer, 0, 255, 0, 255);
+        BUMI_RenderFillRect(renderer, &box);
+        BUMI_RenderFillRect(second_renderer, &box);
+        present_all_ok = BUMI_RenderPresentAll() == 2 && BUMI_RenderPresentAll() == 0;
+    }
+    if (!present_all_ok) {
+        std::cout << "Present all error: " << BUMI_GetError() << std::endl;
+    }
+    BUMI_RendererDestroy(second_renderer);
+    BUMI_WindowDestroy(second);
+
     BUMI_Rect rect = {100, 100, 200, 200};
     bool resize_received = false;
     bool keydown_received = false;
@@ -35,6 +83,67 @@ int main() {
     BUMI_RenderFillRect(renderer, &rect);
     BUMI_RenderPresent(renderer);
 
+    BUMI_StartupTiming startup;
+    if (BUMI_GetStartupTiming(&startup) == 0) {
+        std::cout << "Startup: init " << startup.init_ns / 1000 << " us, first window "
+                  << startup.first_window_ns / 1000 << " us, first present "
+                  << startup.first_present_ns / 1000 << " us" << std::endl;
+    }
+
+    BUMI_FramePacer* pacer = BUMI_FramePacerCreate(window, 0.0);
+
+    // Record the animated part of the test; every present must be accounted for
+    BUMI_Font* font = BUMI_FontCreate(renderer, 2);
+    if (!font) {
+        std::cout << "Font creation error: " << BUMI_GetError() << std::endl;
+    }
+    bool capture_started = BUMI_RenderStartCapture(renderer, "/tmp/bumi_window_test.y4m", BUMI_CAPTURE_Y4M, 60) == 0;
+    uint64_t presents = 0;
+
+    // Two queued resizes of one window coalesce into the latest
+    BUMI_Event resizes[2] = {};
+    for (int i = 0; i < 2; i++) {
+        resizes[i].window.type = BUMI_WINDOWEVENT;
+        resizes[i].window.windowID = 0xFFFFFFFFu;
+        resizes[i].window.window_event = BUMI_WINDOWEVENT_RESIZED;
+        resizes[i].window.data1 = 100 + i;
+        resizes[i].window.timestamp = BUMI_GetTicksNS();
+    }
+    BUMI_Event coalesced;
+    bool events_ok = BUMI_PeepEvents(resizes, 2, BUMI_ADDEVENT, BUMI_WINDOWEVENT, BUMI_WINDOWEVENT) == 2 &&
+                     BUMI_PeepEvents(NULL, 0, BUMI_PEEKEVENT, BUMI_WINDOWEVENT, BUMI_WINDOWEVENT) == 1 &&
+                     BUMI_PeepEvents(&coalesced, 1, BUMI_GETEVENT, BUMI_WINDOWEVENT, BUMI_WINDOWEVENT) == 1 &&
+                     coalesced.window.data1 == 101;
+
+    // Motion does not coalesce across a key event in between
+    BUMI_Event ordered[3] = {};
+    for (int i = 0; i < 3; i++) {
+        ordered[i].common.type = i == 1 ? BUMI_KEYDOWN : BUMI_MOUSEMOTION;
+        ordered[i].common.windowID = 0xFFFFFFFFu;
+        ordered[i].common.timestamp = BUMI_GetTicksNS();
+        ordered[i].motion.xrel = 1.0f;
+    }
+    BUMI_Event drained[3];
+    events_ok = events_ok && BUMI_PeepEvents(ordered, 3, BUMI_ADDEVENT, BUMI_KEYDOWN, BUMI_MOUSEMOTION) == 3 &&
+                BUMI_PeepEvents(drained, 3, BUMI_GETEVENT, BUMI_KEYDOWN, BUMI_MOUSEMOTION) == 3 &&
+                drained[0].type == BUMI_MOUSEMOTION && drained[1].type == BUMI_KEYDOWN &&
+                drained[2].type == BUMI_MOUSEMOTION && drained[2].motion.xrel == 1.0f;
+
+    // A worker thread announces results through user events
+    uint32_t user_type = BUMI_RegisterEvents(1);
+    int user_received = 0;
+    std::thread worker([user_type]() {
+        for (int i = 0; i < 4; i++) {
+            BUMI_Event pushed = {};
+            pushed.user.type = user_type;
+            pushed.user.code = i;
+            BUMI_PushEvent(&pushed);
+        }
+    });
+
+    // After a few warm-up frames the loop should allocate nothing
+    uint64_t warm_allocations = 0;
+
     auto start = std::chrono::steady_clock::now();
     BUMI_Event event;
     while (std::chrono::steady_clock::now() - start < std::chrono::seconds(3)) {
@@ -52,27 +161,66 @@ int main() {
             if (event.type == BUMI_KEYDOWN && event.key.keycode == BUMI_KEY_ESCAPE) {
                 keydown_received = true;
             }
+            if (event.type == user_type && event.user.code == user_received) {
+                user_received++;
+            }
         }
         BUMI_SetRenderDrawColor(renderer, 0, 0, 0, 255);
         BUMI_RenderClear(renderer);
         BUMI_SetRenderDrawColor(renderer, 255, 0, 0, 255);
         BUMI_RenderFillRect(renderer, &rect);
+        if (font) {
+            BUMI_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+            BUMI_RenderText(renderer, font, "Press Escape, resize or close", 10, 10);
+        }
         BUMI_RenderPresent(renderer);
-        BUMI_Delay(16);
+        if (++presents == 30) {
+            warm_allocations = BUMI_GetAllocationCount();
+        }
+        BUMI_FramePacerWait(pacer);
     }
+    uint64_t loop_allocations = BUMI_GetAllocationCount() - warm_allocations;
+    worker.join();
+    BUMI_FramePacerDestroy(pacer);
+
+    bool capture_ok = false;
+    BUMI_CaptureStats stats = {0, 0, 0};
+    if (capture_started && BUMI_RenderGetCaptureStats(renderer, &stats) == 0 && BUMI_RenderStopCapture(renderer) == 0) {
+        // Readbacks still in flight at the stats query land during stop
+        capture_ok = stats.captured + stats.dropped <= presents && stats.written <= stats.captured;
+    }
+    if (!capture_ok) {
+        std::cout << "Capture error: " << BUMI_GetError() << std::endl;
+    }
+
+    BUMI_EventLatency latency = {0, 0, 0, 0};
+    BUMI_GetEventLatency(&latency, false);
 
     std::cout << "Test results:" << std::endl;
     std::cout << "Window created successfully: " << (window ? "PASS" : "FAIL") << std::endl;
+    std::cout << "Window found by ID: " << (BUMI_GetWindowFromID(window->id) == window ? "PASS" : "FAIL") << std::endl;
     std::cout << "Renderer created successfully: " << (renderer ? "PASS" : "FAIL") << std::endl;
+    std::cout << "Frame capture (" << stats.captured << " captured, " << stats.dropped << " dropped): "
+              << (capture_ok ? "PASS" : "FAIL") << std::endl;
+    std::cout << "Render target readback: " << (target_ok ? "PASS" : "FAIL") << std::endl;
+    std::cout << "Present all with interleaved draws: " << (present_all_ok ? "PASS" : "FAIL") << std::endl;
+    std::cout << "Event queue coalescing: " << (events_ok ? "PASS" : "FAIL") << std::endl;
+    std::cout << "Render loop allocations after warm-up (" << loop_allocations << "): "
+              << (presents <= 30 ? "SKIPPED" : loop_allocations == 0 ? "PASS" : "FAIL") << std::endl;
+    std::cout << "User events pushed from a thread: " << (user_received == 4 ? "PASS" : "FAIL") << std::endl;
+    std::cout << "Event latency over " << latency.count << " events: p50 " << latency.p50_ns / 1000.0
+              << " us, p99 " << latency.p99_ns / 1000.0 << " us" << std::endl;
     std::cout << "Resize event received: " << (resize_received ? "PASS" : "SKIPPED (resize window during test)") << std::endl;
     std::cout << "Escape key event received: " << (keydown_received ? "PASS" : "SKIPPED (press Escape during test)") << std::endl;
     std::cout << "Close event received: " << (close_received ? "PASS" : "SKIPPED (close window during test)") << std::endl;
 
+    BUMI_FontDestroy(font);
     BUMI_RendererDestroy(renderer);
     BUMI_WindowDestroy(window);
     BUMI_Quit();
 
-    if (!window || !renderer) {
+    if (!window || !renderer || !target_ok || !present_all_ok || !capture_ok || !events_ok || user_received != 4 ||
+        (presents > 30 && loop_allocations != 0)) {
         return 1;
     }
     return 0;